@@ -0,0 +1,99 @@
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <wstdisplay/atlas_file.hpp>
+#include <wstdisplay/software_surface.hpp>
+
+using namespace wstdisplay;
+
+namespace {
+
+void print_usage(char const* program)
+{
+  std::cout << "Usage: " << program << " [OPTION]... OUTPUT DIRECTORY...\n"
+            << "Pack all images below DIRECTORY into an atlas file for SurfaceManager::load_atlas()\n"
+            << "\n"
+            << "  --page-size N   width and height of the atlas pages (default: 2048)\n"
+            << "  --padding N     pixels of repeated edge around each image (default: 1)\n"
+            << "\n"
+            << "Images are stored under the path they were found at, i.e. DIRECTORY/...,\n"
+            << "so run this from the directory the game loads its data from.\n";
+}
+
+bool is_image(std::filesystem::path const& path)
+{
+  std::string const ext = path.extension().string();
+  return ext == ".png" || ext == ".jpg" || ext == ".jpeg";
+}
+
+int run(int argc, char** argv)
+{
+  int page_size = 2048;
+  int padding = 1;
+  std::vector<std::filesystem::path> rest;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string const arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      print_usage(argv[0]);
+      return EXIT_SUCCESS;
+    } else if ((arg == "--page-size" || arg == "--padding") && i + 1 < argc) {
+      int const value = std::stoi(argv[++i]);
+      (arg == "--page-size" ? page_size : padding) = value;
+    } else if (arg.starts_with("--")) {
+      throw std::runtime_error("unknown option " + arg);
+    } else {
+      rest.emplace_back(arg);
+    }
+  }
+
+  if (rest.size() < 2) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  AtlasBuilder builder(geom::isize(page_size, page_size), padding);
+
+  int count = 0;
+  for (auto it = rest.begin() + 1; it != rest.end(); ++it)
+  {
+    for (auto const& entry : std::filesystem::recursive_directory_iterator(*it))
+    {
+      if (entry.is_regular_file() && is_image(entry.path())) {
+        builder.add(entry.path().lexically_normal().generic_string(),
+                    SoftwareSurface::from_file(entry.path()));
+        count += 1;
+      }
+    }
+  }
+
+  builder.write(rest.front());
+
+  std::vector<float> const occupancy = builder.get_occupancy();
+  std::cout << rest.front().string() << ": " << count << " images on "
+            << occupancy.size() << " pages" << std::endl;
+  for (size_t page = 0; page < occupancy.size(); ++page) {
+    std::cout << "  page " << page << ": " << static_cast<int>(occupancy[page] * 100.0f) << "% used" << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  try {
+    return run(argc, argv);
+  } catch (std::exception const& err) {
+    std::cerr << "error: " << err.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+}
+
+/* EOF */
@@ -72,6 +72,7 @@ void run()
     gc.clear(surf::palette::magenta);
     gc.fill_rect(geom::frect(50, 50, 100, 100), surf::palette::cyan);
     gc.draw_rect(geom::frect(50, 50, 100, 100), surf::palette::red);
+    gc.flush();
 
     window->swap_buffers();
     system.update();
@@ -19,8 +19,59 @@
 
 void assert_gl_loc(char const* file, int line, char const* message = nullptr);
 
-#define assert_gl() assert_gl_loc(__FILE__, __LINE__)
-#define assert_gl_msg(msg) assert_gl_loc(__FILE__, __LINE__, (msg))
+/** glGetError() polling done by assert_gl(), disabled automatically
+    when a debug message callback is installed */
+extern bool g_assert_gl_enabled;
+
+#ifdef WSTDISPLAY_NO_ASSERT_GL
+#  define assert_gl() ((void)0)
+#  define assert_gl_msg(msg) ((void)0)
+#else
+#  define assert_gl() (g_assert_gl_enabled ? assert_gl_loc(__FILE__, __LINE__) : (void)0)
+#  define assert_gl_msg(msg) (g_assert_gl_enabled ? assert_gl_loc(__FILE__, __LINE__, (msg)) : (void)0)
+#endif
+
+namespace wstdisplay {
+
+/** Register a GL_KHR_debug message callback that logs errors as they
+    happen, together with the innermost GLDebugScope. Returns false
+    when the extension isn't available. */
+bool install_gl_debug_callback();
+
+/** Marks a region of OpenGL calls, the name and location show up in
+    messages from the debug callback and as debug group in tools like
+    apitrace or RenderDoc. Costs next to nothing when no callback is
+    installed. */
+class GLDebugScope
+{
+public:
+  GLDebugScope(char const* name, char const* file, int line);
+  ~GLDebugScope();
+
+  static GLDebugScope const* current();
+
+  char const* get_name() const { return m_name; }
+  char const* get_file() const { return m_file; }
+  int get_line() const { return m_line; }
+
+private:
+  char const* m_name;
+  char const* m_file;
+  int m_line;
+  GLDebugScope const* m_parent;
+  bool m_group_pushed;
+
+private:
+  GLDebugScope(const GLDebugScope&) = delete;
+  GLDebugScope& operator=(const GLDebugScope&) = delete;
+};
+
+} // namespace wstdisplay
+
+#define GL_DEBUG_SCOPE_CONCAT2(a, b) a##b
+#define GL_DEBUG_SCOPE_CONCAT(a, b) GL_DEBUG_SCOPE_CONCAT2(a, b)
+#define GL_DEBUG_SCOPE(name) \
+  ::wstdisplay::GLDebugScope GL_DEBUG_SCOPE_CONCAT(gl_debug_scope_, __LINE__)((name), __FILE__, __LINE__)
 
 #endif
 
@@ -0,0 +1,157 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_WINDSTILLE_DISPLAY_ATLAS_FILE_HPP
+#define HEADER_WINDSTILLE_DISPLAY_ATLAS_FILE_HPP
+
+#include <filesystem>
+#include <span>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <geom/rect.hpp>
+#include <geom/size.hpp>
+
+#include "software_surface.hpp"
+
+namespace wstdisplay {
+
+/** Layout of a baked atlas file, all values are little endian:
+
+    AtlasFileHeader
+    AtlasFileEntry[entry_count]   sorted by name
+    char[names_size]              names, not null terminated
+    RGBA8 pixels of every page    at pages_offset, 16 byte aligned
+*/
+struct AtlasFileHeader
+{
+  static constexpr char MAGIC[8] = { 'W', 'S', 'T', 'A', 'T', 'L', 'A', 'S' };
+  static constexpr uint32_t VERSION = 1;
+
+  char magic[8];
+  uint32_t version;
+
+  uint32_t page_count;
+  uint32_t page_width;
+  uint32_t page_height;
+
+  uint32_t entry_count;
+  uint32_t names_size;
+
+  uint64_t pages_offset;
+};
+
+static_assert(sizeof(AtlasFileHeader) == 40);
+
+struct AtlasFileEntry
+{
+  /** into the name block */
+  uint32_t name_offset;
+  uint32_t name_length;
+
+  uint32_t page;
+
+  /** uv rect on the page */
+  float u1, v1, u2, v2;
+
+  /** size of the surface in pixels */
+  float width, height;
+};
+
+static_assert(sizeof(AtlasFileEntry) == 36);
+
+/** Packs images into pages and writes them as an atlas file. Doesn't
+    touch OpenGL, so it can run offline. */
+class AtlasBuilder final
+{
+public:
+  AtlasBuilder(geom::isize const& page_size, int padding = 1);
+
+  /** \a name is what SurfaceManager::get() will be asked for */
+  void add(std::string name, SoftwareSurface surface);
+
+  /** Pack everything that was added and write the file */
+  void write(std::filesystem::path const& filename);
+
+  /** Fraction of every page that is used, valid after write() */
+  std::vector<float> get_occupancy() const;
+
+private:
+  struct Image
+  {
+    std::string name;
+    SoftwareSurface surface;
+  };
+
+  geom::isize m_page_size;
+  int m_padding;
+  std::vector<Image> m_images;
+  std::vector<float> m_occupancy;
+
+private:
+  AtlasBuilder(const AtlasBuilder&) = delete;
+  AtlasBuilder& operator=(const AtlasBuilder&) = delete;
+};
+
+/** Read-only view of an atlas file, which is memory mapped, so that
+    neither the index nor the pixels get copied */
+class AtlasFile final
+{
+public:
+  /** Throws std::runtime_error when the file isn't a valid atlas */
+  AtlasFile(std::filesystem::path const& filename);
+  ~AtlasFile();
+
+  geom::isize get_page_size() const;
+  int get_page_count() const;
+
+  /** RGBA8 pixels of \a page, rows are tightly packed */
+  void const* get_page_data(int page) const;
+
+  std::span<AtlasFileEntry const> get_entries() const { return m_entries; }
+  std::string_view get_name(AtlasFileEntry const& entry) const;
+
+  /** Binary search for \a name, returns nullptr when it's missing */
+  AtlasFileEntry const* find(std::string_view name) const;
+
+private:
+  void validate(std::filesystem::path const& filename);
+  void unmap();
+
+private:
+  uint8_t const* m_data;
+  size_t m_size;
+
+  /** only used where mmap() isn't available */
+  std::vector<uint8_t> m_buffer;
+
+  AtlasFileHeader const* m_header;
+  std::span<AtlasFileEntry const> m_entries;
+  char const* m_names;
+
+private:
+  AtlasFile(const AtlasFile&) = delete;
+  AtlasFile& operator=(const AtlasFile&) = delete;
+};
+
+} // namespace wstdisplay
+
+#endif
+
+/* EOF */
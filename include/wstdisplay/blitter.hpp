@@ -33,6 +33,13 @@ namespace wstdisplay {
 */
 void generate_border(SoftwareSurface& surface, int x_pos, int y_pos, int width, int height);
 
+/** Copy \a src to \a x_pos, \a y_pos of \a dst and repeat its edge
+    pixels \a border times to the outside, like generate_border(). \a
+    dst has to be RGBA8 and large enough for the border, \a src can
+    also be RGB8. Other formats throw std::runtime_error. */
+void blit_with_border(SoftwareSurface const& src, SoftwareSurface& dst,
+                      int x_pos, int y_pos, int border);
+
 } // namespace wstdisplay
 
 #endif
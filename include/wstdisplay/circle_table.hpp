@@ -0,0 +1,46 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HEADER_WINDSTILLE_DISPLAY_CIRCLE_TABLE_HPP
+#define HEADER_WINDSTILLE_DISPLAY_CIRCLE_TABLE_HPP
+
+#include <span>
+
+#include <glm/glm.hpp>
+
+namespace wstdisplay {
+
+/** Points on the unit circle at \a segments + 1 evenly spaced angles,
+    counterclockwise from (1, 0). The last point is exactly the first
+    and, when \a segments is a multiple of 4, the axis points are
+    exact as well. Each table is generated once and stays valid. */
+std::span<glm::vec2 const> unit_circle(int segments);
+
+/** The first quarter of unit_circle(segments * 4), from (1, 0) to
+    exactly (0, 1), \a segments + 1 points */
+std::span<glm::vec2 const> quarter_arc(int segments);
+
+/** Segment count for a full circle with a radius of \a screen_radius
+    pixels, so that the polygon stays within a quarter pixel of the
+    circle. Always a multiple of 4. */
+int circle_segments(float screen_radius);
+
+} // namespace wstdisplay
+
+#endif
+
+/* EOF */
@@ -17,11 +17,17 @@
 #ifndef HEADER_WINDSTILLE_DISPLAY_DRAWING_CONTEXT_HPP
 #define HEADER_WINDSTILLE_DISPLAY_DRAWING_CONTEXT_HPP
 
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <vector>
 
 #include <geom/fwd.hpp>
 #include <surf/fwd.hpp>
 
+#include <wstdisplay/frame_arena.hpp>
+#include <wstdisplay/primitive.hpp>
+#include <wstdisplay/stroker.hpp>
 #include <wstdisplay/scenegraph/drawable.hpp>
 
 #include "texture.hpp"
@@ -35,6 +41,7 @@ class GraphicsContext;
 class SceneContext;
 class Surface;
 class SurfaceDrawingParameters;
+class VertexArrayDrawable;
 
 /** The DrawingContext collects all Drawables and allows you to
     flush them all down to the graphics card in one run, this has the
@@ -44,20 +51,70 @@ class SurfaceDrawingParameters;
     be usefull for post-processing effects and such. */
 class DrawingContext
 {
+public:
+  /** Numbers from the last call to render() */
+  struct Stats
+  {
+    /** Drawables submitted */
+    int requests = 0;
+
+    /** Draw calls issued, either a batch or a Drawable::render() */
+    int draws = 0;
+
+    /** Drawables that got merged into a preceding batch */
+    int merged = 0;
+  };
+
 private:
-  using Drawables = std::vector<std::unique_ptr<Drawable> >;
+  /** Storage for the Drawables queued by the draw_*() functions and
+      their geometry, released all at once in clear() */
+  FrameArena m_arena;
+
+  using Drawables = std::vector<DrawablePtr>;
   Drawables drawingrequests;
 
+  /** Sort key of a request: z in the upper 32 bits, then 16 bits of
+      barrier segment, bumped around every Drawable that can't be
+      batched, and 16 bits of BatchState hash. With more than 0xffff
+      segments the key falls back to z alone. \a index is the
+      position in the queue and breaks ties. */
+  struct SortEntry
+  {
+    uint64_t key;
+    uint32_t index;
+  };
+
+  /** Scratch buffers for render(), kept to avoid reallocation */
+  std::vector<SortEntry> m_sort_entries;
+  std::vector<SortEntry> m_sort_scratch;
+  Drawables m_sorted_requests;
+
   std::vector<glm::mat4> modelview_stack;
 
+  /** Scratch geometry used to merge Drawables, kept around to reuse
+      its storage from frame to frame */
+  std::unique_ptr<VertexArrayDrawable> m_batch;
+  Stats m_stats;
+
+  /** Turns draw_line(), draw_lines(), draw_quad() and draw_rect()
+      into triangles */
+  Stroker m_stroker;
+  std::vector<glm::vec2> m_stroke_points;
+
 public:
   DrawingContext();
   ~DrawingContext();
 
-  /** Draws everything in the drawing context to the screen */
+  /** Draws everything in the drawing context to the screen,
+      consecutive Drawables with the same BatchState are merged into
+      a single draw call. Drawables are ordered by z, Drawables of
+      equal z are grouped by their BatchState and otherwise keep the
+      order in which they were queued. */
   void render(GraphicsContext& gc);
 
-  /** Empties the drawing context */
+  Stats const& get_stats() const { return m_stats; }
+
+  /** Empties the drawing context and releases the frame arena */
   void clear();
 
   /** Fills the screen with a given color, this is different from
@@ -73,11 +130,27 @@ public:
   void draw_rect(const geom::frect& rect, const surf::Color& color, float z_pos = 0);
   void fill_rect(const geom::frect& rect, const surf::Color& color, float z_pos = 0);
 
+  /** Bulk versions of fill_rect(), draw_line() and draw(), each call
+      queues a single Drawable. Blend func and depth test for the
+      surfaces are taken from the first element. */
+  void fill_rects(std::span<RectColor const> rects, float z_pos = 0);
+  void draw_lines(std::span<LineColor const> lines, float z_pos = 0);
+  void draw_surfaces(SurfacePtr const& surface, std::span<SurfaceDrawingParameters const> params, float z_pos = 0);
+
+  /** Like draw_surfaces(), but drawn with GraphicsContext::draw_sprites() */
+  void draw_sprites(SurfacePtr const& surface, std::span<SurfaceDrawingParameters const> params, float z_pos = 0);
+
   void draw_quad(const geom::fquad& quad, const surf::Color& color, float z_pos = 0);
   void fill_quad(const geom::fquad& quad, const surf::Color& color, float z_pos = 0);
 
+  /** Anti-aliased circles drawn with GraphicsContext::draw_shapes(),
+      \a stroke is the width of the outline */
+  void draw_circle(const geom::fpoint& pos, float radius, const surf::Color& color, float stroke = 1.0f, float z_pos = 0);
+  void fill_circle(const geom::fpoint& pos, float radius, const surf::Color& color, float z_pos = 0);
+
   /*{ */
   void draw(std::unique_ptr<Drawable> request);
+  void draw(DrawablePtr request);
   void draw(SurfacePtr surface, const geom::fpoint& pos, float z = 0, float alpha = 0);
   void draw(SurfacePtr surface, float x, float y, float z = 0, float alpha = 0);
   void draw(SurfacePtr surface, const SurfaceDrawingParameters& params, float z_pos = 0);
@@ -107,6 +180,21 @@ public:
   /** Return the area of the screen that will be visible*/
   geom::frect get_clip_rect();
 
+private:
+  void sort_requests();
+
+  /** Queue the outline of m_stroke_points as a single Drawable */
+  void stroke(bool closed, const surf::Color& color, float z_pos);
+
+  /** Construct a Drawable in the frame arena and queue it */
+  template<typename T, typename ...Args>
+  T& emplace(Args&&... args)
+  {
+    T* drawable = new (m_arena.allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    draw(DrawablePtr(drawable, DrawableDeleter{true}));
+    return *drawable;
+  }
+
 private:
   DrawingContext (const DrawingContext&);
   DrawingContext& operator= (const DrawingContext&);
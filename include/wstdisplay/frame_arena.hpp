@@ -0,0 +1,76 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HEADER_WINDSTILLE_DISPLAY_FRAME_ARENA_HPP
+#define HEADER_WINDSTILLE_DISPLAY_FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace wstdisplay {
+
+/** Linear allocator for data that only lives for a single frame.
+    Allocation bumps a pointer, deallocation is a no-op and reset()
+    releases everything at once while keeping the chunks around for
+    the next frame. Objects placed in the arena still need their
+    destructor called before reset(). */
+class FrameArena final : public std::pmr::memory_resource
+{
+public:
+  FrameArena(size_t chunk_size = 256 * 1024);
+  ~FrameArena() override;
+
+  /** Release all allocations, previously allocated memory must no
+      longer be in use */
+  void reset();
+
+  /** Bytes handed out since the last reset() */
+  size_t get_bytes_used() const { return m_bytes_used; }
+
+  /** Bytes reserved from the system */
+  size_t get_bytes_reserved() const;
+
+private:
+  void* do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+  bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override;
+
+private:
+  struct Chunk
+  {
+    std::unique_ptr<std::byte[]> data;
+    size_t size;
+  };
+
+  size_t m_chunk_size;
+  std::vector<Chunk> m_chunks;
+  size_t m_current;
+  size_t m_offset;
+  size_t m_bytes_used;
+
+private:
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+};
+
+} // namespace wstdisplay
+
+#endif
+
+/* EOF */
@@ -0,0 +1,66 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_WINDSTILLE_DISPLAY_FULLSCREEN_TRIANGLE_HPP
+#define HEADER_WINDSTILLE_DISPLAY_FULLSCREEN_TRIANGLE_HPP
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "shader_program.hpp"
+#include "texture.hpp"
+
+namespace wstdisplay {
+
+class GraphicsContext;
+
+/** A single triangle that covers the whole viewport. It has no vertex
+    data, vertex shaders derive the position from gl_VertexID with
+
+      vec2 ndc = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+
+    Unlike a quad it has no diagonal seam, along which fragments get
+    shaded twice. */
+class FullscreenTriangle final
+{
+public:
+  FullscreenTriangle();
+  ~FullscreenTriangle();
+
+  /** Copy \a texture onto the viewport, \a uv1 and \a uv2 are the
+      texture coordinates at the top left and bottom right corner */
+  void draw(GraphicsContext& gc, TexturePtr const& texture,
+            glm::vec2 const& uv1, glm::vec2 const& uv2,
+            GLenum blend_sfactor = GL_SRC_ALPHA, GLenum blend_dfactor = GL_ONE_MINUS_SRC_ALPHA);
+
+  /** Draw with the program and state that are currently in use */
+  void draw(GraphicsContext& gc);
+
+private:
+  ShaderProgramPtr m_program;
+  GLuint m_vao;
+
+private:
+  FullscreenTriangle(const FullscreenTriangle&) = delete;
+  FullscreenTriangle& operator=(const FullscreenTriangle&) = delete;
+};
+
+} // namespace wstdisplay
+
+#endif
+
+/* EOF */
@@ -0,0 +1,42 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HEADER_WINDSTILLE_DISPLAY_GEOMETRY_BUILDER_HPP
+#define HEADER_WINDSTILLE_DISPLAY_GEOMETRY_BUILDER_HPP
+
+#include <stdint.h>
+#include <memory_resource>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace wstdisplay {
+
+/** The list primitive that \a mode gets normalized to: fans and
+    strips become GL_TRIANGLES, loops and line strips GL_LINES */
+GLenum list_mode(GLenum mode);
+
+/** Append the indices that draw \a count vertices starting at
+    \a first, given as \a mode, as list_mode(mode) */
+void append_list_indices(GLenum mode, uint32_t first, uint32_t count,
+                         std::pmr::vector<uint32_t>& indices);
+
+} // namespace wstdisplay
+
+#endif
+
+/* EOF */
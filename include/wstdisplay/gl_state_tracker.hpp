@@ -0,0 +1,116 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HEADER_WINDSTILLE_DISPLAY_GL_STATE_TRACKER_HPP
+#define HEADER_WINDSTILLE_DISPLAY_GL_STATE_TRACKER_HPP
+
+#include <array>
+#include <optional>
+
+#include <GL/glew.h>
+
+#include "shader_program.hpp"
+#include "texture.hpp"
+
+namespace wstdisplay {
+
+/** Shadows the parts of the OpenGL state that change between
+    Drawables and drops calls that wouldn't change anything. Bound
+    programs and textures are kept referenced, so that their handles
+    can't be recycled while the tracker still believes them bound.
+    Code that changes the tracked state behind the back of the
+    tracker has to call invalidate(). */
+class GLStateTracker final
+{
+public:
+  static constexpr int MAX_TEXTURE_UNITS = 4;
+
+  /** Unit left to code that binds textures only to modify them, the
+      tracker never binds to it. The active unit isn't shadowed, as
+      such code switches it freely. */
+  static constexpr int SCRATCH_TEXTURE_UNIT = MAX_TEXTURE_UNITS;
+
+  struct Stats
+  {
+    /** State changes passed on to OpenGL */
+    int applied = 0;
+
+    /** State changes dropped as redundant */
+    int skipped = 0;
+  };
+
+public:
+  GLStateTracker();
+
+  /** nullptr unbinds the current program */
+  void use_program(ShaderProgramPtr const& program);
+
+  /** GL_BLEND, GL_DEPTH_TEST, GL_SCISSOR_TEST and GL_STENCIL_TEST are
+      tracked, other caps are passed through */
+  void set_enabled(GLenum cap, bool enabled);
+  void enable(GLenum cap) { set_enabled(cap, true); }
+  void disable(GLenum cap) { set_enabled(cap, false); }
+
+  void blend_func(GLenum sfactor, GLenum dfactor);
+
+  /** Bind \a texture to GL_TEXTURE_2D of \a unit, nullptr unbinds */
+  void bind_texture(int unit, TexturePtr const& texture);
+
+  void bind_vertex_array(GLuint vao);
+
+  /** Forget all shadowed state, the next call of each kind will be
+      passed on unconditionally */
+  void invalidate();
+
+  /** Numbers accumulated since the last call to reset_stats(),
+      meant to be reset once per frame */
+  Stats const& get_stats() const { return m_stats; }
+  void reset_stats() { m_stats = Stats(); }
+
+private:
+  /** Return \a changed and count it */
+  bool count(bool changed);
+
+  std::optional<bool>* get_cap(GLenum cap);
+
+private:
+  std::optional<ShaderProgramPtr> m_program;
+
+  std::optional<bool> m_blend;
+  std::optional<bool> m_depth_test;
+  std::optional<bool> m_scissor_test;
+  std::optional<bool> m_stencil_test;
+
+  std::optional<GLenum> m_blend_sfactor;
+  std::optional<GLenum> m_blend_dfactor;
+
+  std::array<std::optional<TexturePtr>, MAX_TEXTURE_UNITS> m_textures;
+
+  std::optional<GLuint> m_vertex_array;
+
+  Stats m_stats;
+
+private:
+  GLStateTracker(const GLStateTracker&) = delete;
+  GLStateTracker& operator=(const GLStateTracker&) = delete;
+};
+
+} // namespace wstdisplay
+
+#endif
+
+/* EOF */
@@ -18,32 +18,161 @@
 #define HEADER_SUPERTUX_VIDEO_GL_GL_VERTEX_ARRAYS_HPP
 
 #include <stddef.h>
+#include <stdint.h>
 #include <span>
 
 #include <GL/glew.h>
+#include <surf/color.hpp>
 
 namespace wstdisplay {
 
-class GraphicsContext;
+/** Fixed attribute locations used by the streamed vertex format,
+    shaders get them bound by name when linked */
+enum class VertexAttrib : GLuint
+{
+  POSITION = 0,
+  TEXCOORD = 1,
+  DIFFUSE = 2
+};
+
+/** Vertex colour as normalized unsigned bytes, in memory order */
+struct RGBA8
+{
+  uint8_t r, g, b, a;
+
+  static constexpr RGBA8 white() { return {255, 255, 255, 255}; }
+
+  /** Components are clamped to [0, 1] */
+  static RGBA8 from_color(surf::Color const& color);
+};
+
+static_assert(sizeof(RGBA8) == 4);
+
+/** Interleaved vertex as it is stored in the stream buffer */
+struct StreamVertex
+{
+  float x, y, z;
+  float u, v;
+  RGBA8 color;
+};
+
+static_assert(sizeof(StreamVertex) == 24);
+
+/** Vertex with float colours, for values outside of [0, 1] */
+struct HDRStreamVertex
+{
+  float x, y, z;
+  float u, v;
+  float r, g, b, a;
+};
+
+static_assert(sizeof(HDRStreamVertex) == 36);
+
+/** Streams vertex data for immediate drawing through a single ring
+    buffer. Vertices are appended behind the previous upload using
+    unsynchronized mapping, when the buffer is full its storage is
+    orphaned and writing starts over at the front. Indices are
+    streamed the same way through an element buffer that is attached
+    to both vertex arrays. */
+class GLStateTracker;
 
 class GLVertexArrays final
 {
 public:
-  GLVertexArrays(GraphicsContext& context);
+  struct Stats
+  {
+    /** Bytes written into the vertex and element buffers */
+    size_t bytes_streamed = 0;
+
+    /** Number of calls to upload() and upload_indices() */
+    int uploads = 0;
+
+    /** Number of times the buffer storage got re-specified */
+    int orphans = 0;
+  };
+
+public:
+  /** \a usage is passed on to glBufferData(), GL_STATIC_DRAW is
+      meant for retained geometry that is uploaded once. The vertex
+      arrays are set up through \a state. */
+  GLVertexArrays(GLStateTracker& state, size_t capacity = 4 * 1024 * 1024, GLenum usage = GL_STREAM_DRAW);
   ~GLVertexArrays();
 
-  void bind();
+  /** The vertex array object describing the stream buffer as
+      StreamVertex, or as HDRStreamVertex when \a hdr is set. Bind it
+      through GLStateTracker::bind_vertex_array() */
+  GLuint get_vertex_array(bool hdr = false) const { return hdr ? m_hdr_vao : m_vao; }
+
+  /** Interleave and append the given arrays to the ring buffer,
+      \a texcoords and \a colors may be empty. Without colors the
+      diffuse attribute is set to a constant white instead. Expects
+      get_vertex_array() to be bound. Returns the index of the first
+      vertex to be passed to glDrawArrays() */
+  GLint upload(std::span<float const> positions,
+               std::span<float const> texcoords,
+               std::span<RGBA8 const> colors);
+
+  /** Like upload(), but with four unclamped floats per colour,
+      expects get_vertex_array(true) to be bound */
+  GLint upload_hdr(std::span<float const> positions,
+                   std::span<float const> texcoords,
+                   std::span<float const> colors);
+
+  /** Append indices to the element buffer, narrowing them to 16 bit
+      when \a type is GL_UNSIGNED_SHORT. Expects one of the vertex
+      arrays to be bound. Returns the byte offset to be passed as
+      indices pointer to glDrawElements() */
+  GLintptr upload_indices(std::span<uint32_t const> indices, GLenum type);
+  GLintptr upload_indices(std::span<uint16_t const> indices);
+
+  /** Reset the constant diffuse value when the last upload() for the
+      given format had no colors, for drawing previously uploaded
+      vertices again */
+  void apply_constant_color(bool hdr) const;
+
+  /** Resize the ring buffer, \a capacity is given in bytes */
+  void set_capacity(size_t capacity);
+  size_t get_capacity() const { return m_capacity; }
+
+  /** Resize the element buffer, expects one of the vertex arrays to
+      be bound */
+  void set_index_capacity(size_t capacity);
+  size_t get_index_capacity() const { return m_index_capacity; }
+
+  /** Numbers accumulated since the last call to reset_stats(),
+      meant to be reset once per frame */
+  Stats const& get_stats() const { return m_stats; }
+  void reset_stats() { m_stats = Stats(); }
+
+private:
+  void orphan();
+  void orphan_indices();
+
+  void* map_indices(size_t bytes, size_t alignment);
+  GLintptr unmap_indices(size_t bytes);
+
+  /** Make room for \a count vertices of \a stride bytes and map
+      them, m_offset is aligned to \a stride */
+  void* map(size_t count, size_t stride);
+  GLint unmap(size_t count, size_t stride);
 
-  void set_positions(std::span<float const> data);
-  void set_texcoords(std::span<float const> data);
-  void set_colors(std::span<float const> data);
+  /** Switch the diffuse attribute of the bound vertex array between
+      the stream and a constant white */
+  void set_diffuse_array(bool& enabled, bool enable);
 
 private:
-  GraphicsContext& m_gc;
   GLuint m_vao;
-  GLuint m_positions_buffer;
-  GLuint m_texcoords_buffer;
-  GLuint m_color_buffer;
+  GLuint m_hdr_vao;
+  bool m_diffuse_enabled;
+  bool m_hdr_diffuse_enabled;
+  GLuint m_buffer;
+  GLenum m_usage;
+  size_t m_capacity;
+  size_t m_offset;
+  GLuint m_index_buffer;
+  size_t m_index_capacity;
+  size_t m_index_offset;
+  Stats m_stats;
 
 private:
   GLVertexArrays(const GLVertexArrays&) = delete;
@@ -17,6 +17,9 @@
 #ifndef HEADER_WINDSTILLE_DISPLAY_GRAPHICSCONTEXT_HPP
 #define HEADER_WINDSTILLE_DISPLAY_GRAPHICSCONTEXT_HPP
 
+#include <memory>
+#include <optional>
+#include <span>
 #include <stack>
 #include <vector>
 
@@ -26,19 +29,50 @@
 #include <surf/fwd.hpp>
 
 #include "framebuffer.hpp"
+#include "fullscreen_triangle.hpp"
+#include "gl_state_tracker.hpp"
 #include "gl_vertex_arrays.hpp"
+#include "grid_renderer.hpp"
+#include "primitive.hpp"
 #include "shader_program.hpp"
+#include "shape_renderer.hpp"
+#include "stroker.hpp"
+#include "surface.hpp"
+#include "scenegraph/batch_state.hpp"
 
 namespace wstdisplay {
 
 class GLVertexArrays;
+class SpriteRenderer;
+class VertexArrayDrawable;
 
+/** How the circle, arc and rounded rect helpers of GraphicsContext
+    draw their shapes */
+enum class ShapeBackend
+{
+  /** Polygons built on the CPU */
+  TESSELLATED,
+
+  /** One anti-aliased quad per shape through draw_shapes() */
+  SDF
+};
+
+/** The shape functions (fill_rect(), draw_line(), ...) don't draw
+    right away, but collect their geometry in a batch that is drawn
+    with a single call on flush(). The same goes for draw_shapes().
+    flush() happens automatically when the render state, the
+    matrices, the cliprect or the framebuffer change and before any
+    VertexArrayDrawable gets rendered. */
 class GraphicsContext
 {
 public:
   GraphicsContext();
   ~GraphicsContext();
 
+  /** Draw the pending shape batch, must be called before issuing raw
+      OpenGL calls or swapping buffers */
+  void flush();
+
   void clear(surf::Color const& color);
 
   void fill_quad(const geom::fquad& quad, const surf::Color& color);
@@ -56,14 +90,44 @@ public:
   void draw_line(const geom::fline& line, const surf::Color& color);
   void draw_line(const geom::fpoint& pos1, const geom::fpoint& pos2, const surf::Color& color);
 
-  void draw_circle(const geom::fpoint& pos, float radius, const surf::Color& color, int segments = 16);
-  void fill_circle(const geom::fpoint& pos, float radius, const surf::Color& color, int segments = 16);
+  /** Bulk versions of fill_rect(), draw_line() and Surface::draw(),
+      each call results in a single block of vertices. Blend func and
+      depth test for the surfaces are taken from the first element. */
+  void fill_rects(std::span<RectColor const> rects);
+  void draw_lines(std::span<LineColor const> lines);
+  void draw_surfaces(SurfacePtr const& surface, std::span<SurfaceDrawingParameters const> params);
+
+  /** Like draw_surfaces(), but with one instanced draw call and 32
+      bytes per sprite, z_pos of \a params is ignored */
+  void draw_sprites(SurfacePtr const& surface, std::span<SurfaceDrawingParameters const> params);
 
-  void draw_arc(const geom::fpoint& pos, float radius, float start, float end, const surf::Color& color, int segments = 16);
-  void fill_arc(const geom::fpoint& pos, float radius, float start, float end, const surf::Color& color, int segments = 16);
+  /** \a segments is the number of segments for the full circle, 0
+      picks it from the radius the circle has on screen */
+  void draw_circle(const geom::fpoint& pos, float radius, const surf::Color& color, int segments = 0);
+  void fill_circle(const geom::fpoint& pos, float radius, const surf::Color& color, int segments = 0);
+
+  /** \a start and \a end are in degrees */
+  void draw_arc(const geom::fpoint& pos, float radius, float start, float end, const surf::Color& color, int segments = 0);
+  void fill_arc(const geom::fpoint& pos, float radius, float start, float end, const surf::Color& color, int segments = 0);
 
   void draw_grid(const geom::fpoint& offset, const geom::fsize& size, const surf::Color& color);
 
+  /** Draw \a grid over the whole viewport, the cost does not depend
+      on the number of cells */
+  void draw_grid(Grid const& grid);
+
+  /** Draw anti-aliased shapes, consecutive calls under the same
+      matrices end up in a single instanced draw call */
+  void draw_shapes(std::span<Shape const> shapes);
+
+  /** Width, joins and caps of the draw_*() outlines */
+  void set_stroke_style(StrokeStyle const& style) { m_stroke_style = style; }
+  StrokeStyle const& get_stroke_style() const { return m_stroke_style; }
+  void set_line_width(float width) { m_stroke_style.width = width; }
+
+  void set_shape_backend(ShapeBackend backend) { m_shape_backend = backend; }
+  ShapeBackend get_shape_backend() const { return m_shape_backend; }
+
   void push_cliprect(const geom::irect& rect);
   void pop_cliprect();
 
@@ -90,18 +154,71 @@ public:
 
   ShaderProgramPtr get_default_shader() const { return m_default_shader; }
   GLVertexArrays& get_va() { return m_vertex_arrays; }
+  GLStateTracker& get_state() { return m_state; }
   TexturePtr get_white_texture() const { return m_white_texture; }
 
+  /** Shared by all passes that cover the whole screen */
+  FullscreenTriangle& get_fullscreen_triangle();
+
+  /** Maps screen y through a lookup texture, shared by all
+      GradientDrawables */
+  ShaderProgramPtr const& get_gradient_program();
+
+private:
+  /** Draw the pending shape batch, but leave the shapes queued in
+      the ShapeRenderer, which keep the matrix they were added with */
+  void flush_primitives();
+  void flush_shapes();
+
+  /** Returns a cleared VertexArrayDrawable to build a shape in */
+  VertexArrayDrawable& begin_primitive();
+
+  /** Append the shape to the pending batch */
+  void end_primitive(VertexArrayDrawable& va);
+
+  /** Add the outlines collected in m_stroker to the pending batch */
+  void end_stroke(surf::Color const& color);
+
+  /** Segments for a full circle of \a radius under the current
+      projection and modelview */
+  int segments_for(float radius) const;
+
+  /** Append the arc from \a start to \a end radians to \a points:
+      the exact end points and the unit_circle() points between them,
+      \a segments as in draw_arc() */
+  void arc_points(std::vector<glm::vec2>& points, geom::fpoint const& pos, float radius,
+                  float start, float end, int segments) const;
+
 private:
   geom::isize m_size;
   std::vector<geom::irect> m_cliprects;
 
   ShaderProgramPtr m_default_shader;
+
+  /** created on first use */
+  ShaderProgramPtr m_gradient_program;
   TexturePtr m_white_texture;
   std::stack<glm::mat4> m_modelview_stack;
   glm::mat4 m_projection;
+  GLStateTracker m_state;
   GLVertexArrays m_vertex_arrays;
 
+  std::unique_ptr<VertexArrayDrawable> m_primitive;
+  std::unique_ptr<VertexArrayDrawable> m_primitive_batch;
+  std::optional<BatchState> m_primitive_state;
+  bool m_flushing;
+
+  /** created on first use */
+  std::unique_ptr<SpriteRenderer> m_sprite_renderer;
+  std::unique_ptr<ShapeRenderer> m_shape_renderer;
+  std::unique_ptr<GridRenderer> m_grid_renderer;
+  std::unique_ptr<FullscreenTriangle> m_fullscreen_triangle;
+  ShapeBackend m_shape_backend;
+
+  Stroker m_stroker;
+  StrokeStyle m_stroke_style;
+  std::vector<glm::vec2> m_stroke_points;
+
 private:
   GraphicsContext(const GraphicsContext&) = delete;
   GraphicsContext& operator=(const GraphicsContext&) = delete;
@@ -0,0 +1,76 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_WINDSTILLE_DISPLAY_GRID_RENDERER_HPP
+#define HEADER_WINDSTILLE_DISPLAY_GRID_RENDERER_HPP
+
+#include <GL/glew.h>
+
+#include <geom/point.hpp>
+#include <geom/size.hpp>
+#include <surf/color.hpp>
+
+#include "shader_program.hpp"
+
+namespace wstdisplay {
+
+class GraphicsContext;
+
+/** Parameters of a grid, all coordinates are in the space of the
+    current modelview, widths are in pixels */
+struct Grid
+{
+  /** a line passes through offset in both directions */
+  geom::fpoint offset = geom::fpoint(0.0f, 0.0f);
+  geom::fsize size = geom::fsize(32.0f, 32.0f);
+  surf::Color color = surf::Color(1.0f, 1.0f, 1.0f);
+  float line_width = 1.0f;
+
+  /** every major_every line is drawn in major_color, 0 disables them */
+  int major_every = 0;
+  surf::Color major_color = surf::Color(1.0f, 1.0f, 1.0f);
+  float major_line_width = 1.0f;
+
+  /** lines fade out when their cells get smaller than fade_end pixels
+      and disappear below fade_start, fade_end <= fade_start disables
+      the fading */
+  float fade_start = 4.0f;
+  float fade_end = 12.0f;
+};
+
+/** Draws a grid over the whole viewport with the FullscreenTriangle,
+    the lines are computed in the fragment shader so the
+    cost does not depend on the number of cells */
+class GridRenderer final
+{
+public:
+  GridRenderer();
+
+  void draw(GraphicsContext& gc, Grid const& grid);
+
+private:
+  ShaderProgramPtr m_program;
+
+private:
+  GridRenderer(const GridRenderer&) = delete;
+  GridRenderer& operator=(const GridRenderer&) = delete;
+};
+
+} // namespace wstdisplay
+
+#endif
+
+/* EOF */
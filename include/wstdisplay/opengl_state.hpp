@@ -70,8 +70,7 @@ public:
   ~OpenGLState();
 
   /**
-   * Binds the given \a texture to the given texture \a unit and
-   * enables texturing via glEnable(GL_TEXTURE2D) for the unit.
+   * Binds the given \a texture to the given texture \a unit
    */
   void bind_texture(TexturePtr texture, int unit = 0);
 
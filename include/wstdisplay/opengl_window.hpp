@@ -45,6 +45,10 @@ public:
     Mode mode = Mode::Window;
     bool resizable = false;
     int anti_aliasing = 0;
+
+    /** Request a debug context and report OpenGL errors through
+        GL_KHR_debug instead of polling glGetError() */
+    bool debug = false;
   };
 
 public:
@@ -62,6 +66,8 @@ public:
 
   GraphicsContext& get_gc() const;
 
+  /** Present the frame and reset the per-frame GLStateTracker and
+      GLVertexArrays stats, read them before calling this */
   void swap_buffers();
 
   surf::SoftwareSurface screenshot() const;
@@ -0,0 +1,45 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HEADER_WINDSTILLE_DISPLAY_PRIMITIVE_HPP
+#define HEADER_WINDSTILLE_DISPLAY_PRIMITIVE_HPP
+
+#include <geom/line.hpp>
+#include <geom/rect.hpp>
+#include <surf/color.hpp>
+
+namespace wstdisplay {
+
+/** Element for GraphicsContext::fill_rects() and DrawingContext::fill_rects() */
+struct RectColor
+{
+  geom::frect rect;
+  surf::Color color;
+};
+
+/** Element for GraphicsContext::draw_lines() and DrawingContext::draw_lines() */
+struct LineColor
+{
+  geom::fline line;
+  surf::Color color;
+};
+
+} // namespace wstdisplay
+
+#endif
+
+/* EOF */
@@ -0,0 +1,89 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_WINDSTILLE_DISPLAY_RECT_PACKER_HPP
+#define HEADER_WINDSTILLE_DISPLAY_RECT_PACKER_HPP
+
+#include <optional>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <geom/rect.hpp>
+#include <geom/size.hpp>
+
+namespace wstdisplay {
+
+/** MaxRects allocator for rectangles in a fixed size area. It keeps
+    the list of maximal free rectangles and places each rectangle
+    where it leaves the shortest side over (best short side fit).
+    Doesn't touch OpenGL. */
+class RectPacker final
+{
+public:
+  RectPacker(geom::isize const& size);
+
+  /** Returns the position of a \a size large rect or nothing when it
+      doesn't fit */
+  std::optional<geom::irect> insert(geom::isize const& size);
+
+  /** Return \a rect, which has to come from insert(), to the free
+      space. It gets merged with free neighbours that share a whole
+      edge, other free space stays fragmented until the last rect is
+      freed. */
+  void free(geom::irect const& rect);
+
+  /** Forget all allocations, keeps the memory for reuse */
+  void clear();
+
+  geom::isize get_size() const { return m_size; }
+
+  /** Area and number of the allocated rects */
+  int64_t get_used_area() const { return m_used_area; }
+  int get_count() const { return m_count; }
+
+  /** Fraction of the area that is allocated, from 0 to 1 */
+  float get_occupancy() const;
+
+private:
+  /** Cut \a used out of all free rects */
+  void split(geom::irect const& used);
+
+  /** Remove the free rects from \a first_new on that are contained
+      in another one */
+  void prune(size_t first_new);
+
+private:
+  geom::isize m_size;
+
+  /** m_new_rects is scratch space for split(), both are reused
+      between inserts so that they don't allocate */
+  std::vector<geom::irect> m_free_rects;
+  std::vector<geom::irect> m_new_rects;
+
+  int64_t m_used_area;
+  int m_count;
+
+private:
+  RectPacker(const RectPacker&) = delete;
+  RectPacker& operator=(const RectPacker&) = delete;
+};
+
+} // namespace wstdisplay
+
+#endif
+
+/* EOF */
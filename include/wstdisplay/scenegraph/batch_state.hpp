@@ -0,0 +1,63 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_WINDSTILLE_SCENEGRAPH_BATCH_STATE_HPP
+#define HEADER_WINDSTILLE_SCENEGRAPH_BATCH_STATE_HPP
+
+#include <GL/glew.h>
+
+#include <wstdisplay/shader_program.hpp>
+#include <wstdisplay/texture.hpp>
+
+namespace wstdisplay {
+
+/** The render state of a Drawable, Drawables that share the same
+    BatchState can be merged into a single draw call */
+class BatchState
+{
+public:
+  /** nullptr for the default shader */
+  ShaderProgramPtr program;
+
+  /** nullptr for untextured geometry */
+  TexturePtr texture;
+
+  /** Either GL_TRIANGLES, GL_LINES or GL_POINTS, strips, fans and
+      loops get converted when appended to a batch */
+  GLenum mode;
+
+  GLenum blend_sfactor;
+  GLenum blend_dfactor;
+
+  bool depth_test;
+
+  BatchState() :
+    program(),
+    texture(),
+    mode(GL_TRIANGLES),
+    blend_sfactor(GL_SRC_ALPHA),
+    blend_dfactor(GL_ONE_MINUS_SRC_ALPHA),
+    depth_test(false)
+  {}
+
+  bool operator==(BatchState const& other) const = default;
+};
+
+} // namespace wstdisplay
+
+#endif
+
+/* EOF */
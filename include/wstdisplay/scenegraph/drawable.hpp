@@ -17,13 +17,17 @@
 #ifndef HEADER_WINDSTILLE_SCENEGRAPH_DRAWABLE_HPP
 #define HEADER_WINDSTILLE_SCENEGRAPH_DRAWABLE_HPP
 
+#include <memory>
+
 #include <glm/glm.hpp>
 
 #include <wstdisplay/texture.hpp>
+#include <wstdisplay/scenegraph/batch_state.hpp>
 
 namespace wstdisplay {
 
 class GraphicsContext;
+class VertexArrayDrawable;
 
 class Drawable
 {
@@ -56,6 +60,17 @@ public:
    */
   virtual void render(GraphicsContext& gc, unsigned int mask) = 0;
 
+  /** Drawables that consist of plain geometry can return true here
+      and fill in \a state, the DrawingContext will then merge them
+      with neighbouring Drawables of the same state into a single draw
+      call instead of calling render() */
+  virtual bool get_batch_state(BatchState& /*state*/) const { return false; }
+
+  /** Append the geometry of the Drawable to \a batch, coordinates
+      are given before the modelview is applied. Only called when
+      get_batch_state() returned true. */
+  virtual void append_to_batch(VertexArrayDrawable& /*batch*/) const {}
+
   /** Returns the position at which the request should be drawn */
   float get_z_pos() const { return z_pos; }
 
@@ -72,6 +87,25 @@ private:
   Drawable& operator= (const Drawable&);
 };
 
+/** Deleter for Drawables that might have been placed in a
+    FrameArena, those only get destructed, their memory is released
+    with the arena */
+struct DrawableDeleter
+{
+  bool in_arena = false;
+
+  void operator()(Drawable* drawable) const
+  {
+    if (in_arena) {
+      std::destroy_at(drawable);
+    } else {
+      delete drawable;
+    }
+  }
+};
+
+using DrawablePtr = std::unique_ptr<Drawable, DrawableDeleter>;
+
 } // namespace wstdisplay
 
 #endif
@@ -17,9 +17,9 @@
 #ifndef HEADER_WINDSTILLE_SCENEGRAPH_FILL_SCREEN_PATTERN_DRAWABLE_HPP
 #define HEADER_WINDSTILLE_SCENEGRAPH_FILL_SCREEN_PATTERN_DRAWABLE_HPP
 
+#include <wstdisplay/graphics_context.hpp>
 #include <wstdisplay/texture.hpp>
 #include <wstdisplay/scenegraph/drawable.hpp>
-#include <wstdisplay/scenegraph/vertex_array_drawable.hpp>
 
 namespace wstdisplay {
 
@@ -54,31 +54,7 @@ public:
     u -= m_offset.x() / static_cast<float>(m_texture->get_width());
     v -= m_offset.y() / static_cast<float>(m_texture->get_height());
 
-    VertexArrayDrawable va;
-
-    va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    va.set_texture(m_texture);
-
-    gc.push_matrix();
-    gc.set_modelview(glm::mat4(1.0f));
-
-    va.set_mode(GL_TRIANGLE_FAN);
-    {
-      va.texcoord(u_start, v_start);
-      va.vertex(0, 0);
-
-      va.texcoord(u, v_start);
-      va.vertex(gc.size().width(), 0);
-
-      va.texcoord(u, v);
-      va.vertex(gc.size().width(), gc.size().height());
-
-      va.texcoord(u_start, v);
-      va.vertex(0, gc.size().height());
-    }
-    va.render(gc);
-
-    gc.pop_matrix();
+    gc.get_fullscreen_triangle().draw(gc, m_texture, glm::vec2(u_start, v_start), glm::vec2(u, v));
   }
 };
 
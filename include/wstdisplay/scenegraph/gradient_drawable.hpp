@@ -20,10 +20,15 @@
 #include <vector>
 #include <memory>
 
+#include <geom/size.hpp>
+
 #include <wstdisplay/scenegraph/vertex_array_drawable.hpp>
+#include <wstdisplay/texture.hpp>
 
 namespace wstdisplay {
 
+/** A vertical gradient over the whole screen, \a colors holds groups
+    of start, midpoint, end and two RGBA colors, positions are in [0,1] */
 class GradientDrawable : public Drawable
 {
 public:
@@ -31,10 +36,32 @@ public:
 
   void render(GraphicsContext& gc, unsigned int mask) override;
 
+  void set_colors(std::vector<float> colors);
+
+  /** Evaluate the gradient in the fragment shader from a lookup
+      texture instead of building a band of geometry per stop */
+  void set_lookup_texture(bool enable) { m_use_lut = enable; }
+  bool get_lookup_texture() const { return m_use_lut; }
+
+private:
+  void build_array(GraphicsContext& gc);
+  void build_lut();
+  void render_lut(GraphicsContext& gc);
+
 private:
   std::unique_ptr<VertexArrayDrawable> m_array;
   std::vector<float> m_colors;
 
+  /** Screen size the array was built for */
+  geom::isize m_size;
+
+  /** m_colors changed since m_array or m_lut were built */
+  bool m_array_dirty;
+  bool m_lut_dirty;
+
+  bool m_use_lut;
+  TexturePtr m_lut;
+
 private:
   GradientDrawable(const GradientDrawable&);
   GradientDrawable& operator=(const GradientDrawable&);
@@ -0,0 +1,55 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HEADER_WINDSTILLE_SCENEGRAPH_SHAPE_DRAWABLE_HPP
+#define HEADER_WINDSTILLE_SCENEGRAPH_SHAPE_DRAWABLE_HPP
+
+#include <wstdisplay/graphics_context.hpp>
+#include <wstdisplay/scenegraph/drawable.hpp>
+#include <wstdisplay/shape_renderer.hpp>
+
+namespace wstdisplay {
+
+/** Draws a Shape via GraphicsContext::draw_shapes(), consecutive
+    ShapeDrawables with the same modelview share one draw call */
+class ShapeDrawable : public Drawable
+{
+private:
+  Shape m_shape;
+
+public:
+  ShapeDrawable(Shape const& shape, float z_pos_, const glm::mat4& modelview_)
+    : Drawable(geom::fpoint(0.0f, 0.0f), z_pos_, modelview_),
+      m_shape(shape)
+  {}
+
+  void render(GraphicsContext& gc, unsigned int mask) override
+  {
+    gc.push_matrix();
+    gc.mult_matrix(modelview);
+
+    gc.draw_shapes({&m_shape, 1});
+
+    gc.pop_matrix();
+  }
+};
+
+} // namespace wstdisplay
+
+#endif
+
+/* EOF */
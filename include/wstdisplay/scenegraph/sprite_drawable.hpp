@@ -0,0 +1,62 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HEADER_WINDSTILLE_SCENEGRAPH_SPRITE_DRAWABLE_HPP
+#define HEADER_WINDSTILLE_SCENEGRAPH_SPRITE_DRAWABLE_HPP
+
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include <wstdisplay/graphics_context.hpp>
+#include <wstdisplay/scenegraph/drawable.hpp>
+#include <wstdisplay/surface_drawing_parameters.hpp>
+
+namespace wstdisplay {
+
+/** Draws a Surface many times via GraphicsContext::draw_sprites() */
+class SpriteDrawable : public Drawable
+{
+private:
+  SurfacePtr m_surface;
+  std::pmr::vector<SurfaceDrawingParameters> m_params;
+
+public:
+  SpriteDrawable(SurfacePtr surface, std::span<SurfaceDrawingParameters const> params,
+                 float z_pos_, const glm::mat4& modelview_,
+                 std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+    : Drawable(geom::fpoint(0.0f, 0.0f), z_pos_, modelview_),
+      m_surface(std::move(surface)),
+      m_params(params.begin(), params.end(), resource)
+  {}
+
+  void render(GraphicsContext& gc, unsigned int mask) override
+  {
+    gc.push_matrix();
+    gc.mult_matrix(modelview);
+
+    gc.draw_sprites(m_surface, m_params);
+
+    gc.pop_matrix();
+  }
+};
+
+} // namespace wstdisplay
+
+#endif
+
+/* EOF */
@@ -56,6 +56,26 @@ public:
 
     gc.pop_matrix();
   }
+
+  bool get_batch_state(BatchState& state) const override
+  {
+    if (!surface->get_texture()) {
+      return false;
+    }
+
+    state.program = {};
+    state.texture = surface->get_texture();
+    state.mode = GL_TRIANGLES;
+    state.blend_sfactor = params.blendfunc_src;
+    state.blend_dfactor = params.blendfunc_dst;
+    state.depth_test = params.depth_test;
+    return true;
+  }
+
+  void append_to_batch(VertexArrayDrawable& batch) const override
+  {
+    surface->append(batch, params);
+  }
 };
 
 } // namespace wstdisplay
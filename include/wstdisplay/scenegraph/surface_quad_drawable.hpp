@@ -23,6 +23,7 @@
 #include <geom/quad.hpp>
 
 #include <wstdisplay/scenegraph/drawable.hpp>
+#include <wstdisplay/scenegraph/vertex_array_drawable.hpp>
 
 namespace wstdisplay {
 
@@ -56,7 +57,8 @@ public:
     gc.push_matrix();
     gc.mult_matrix(modelview);
 
-    va.set_mode(GL_TRIANGLE_FAN);
+    va.set_mode(GL_TRIANGLES);
+    va.begin(GL_TRIANGLE_FAN);
     {
       va.texcoord(m_surface->get_uv().left(), m_surface->get_uv().top());
       va.vertex(pos.x() + m_quad.p1.x(), pos.y() + m_quad.p1.y());
@@ -70,11 +72,45 @@ public:
       va.texcoord(m_surface->get_uv().left(), m_surface->get_uv().bottom());
       va.vertex(pos.x() + m_quad.p4.x(), pos.y() + m_quad.p4.y());
     }
+    va.end();
     va.render(gc);
 
     gc.pop_matrix();
   }
 
+  bool get_batch_state(BatchState& state) const override
+  {
+    if (!m_surface->get_texture()) {
+      return false;
+    }
+
+    state.program = {};
+    state.texture = m_surface->get_texture();
+    state.mode = GL_TRIANGLES;
+    state.blend_sfactor = m_params.blendfunc_src;
+    state.blend_dfactor = m_params.blendfunc_dst;
+    state.depth_test = false;
+    return true;
+  }
+
+  void append_to_batch(VertexArrayDrawable& batch) const override
+  {
+    geom::frect const uv = m_surface->get_uv();
+
+    auto corner = [&](geom::fpoint const& p, float u, float v) {
+      batch.color(RGBA8::white());
+      batch.texcoord(u, v);
+      batch.vertex(pos.x() + p.x(), pos.y() + p.y());
+    };
+
+    batch.begin(GL_TRIANGLE_FAN);
+    corner(m_quad.p1, uv.left(), uv.top());
+    corner(m_quad.p2, uv.right(), uv.top());
+    corner(m_quad.p3, uv.right(), uv.bottom());
+    corner(m_quad.p4, uv.left(), uv.bottom());
+    batch.end();
+  }
+
   void set_quad(const geom::fquad& quad) { m_quad = quad; }
 };
 
@@ -17,11 +17,15 @@
 #ifndef HEADER_WINDSTILLE_SCENEGRAPH_VERTEX_ARRAY_DRAWABLE_HPP
 #define HEADER_WINDSTILLE_SCENEGRAPH_VERTEX_ARRAY_DRAWABLE_HPP
 
+#include <array>
+#include <memory>
+#include <memory_resource>
 #include <span>
-#include <unordered_map>
 #include <vector>
 
 #include <surf/color.hpp>
+#include <wstdisplay/gl_vertex_arrays.hpp>
+#include <wstdisplay/primitive.hpp>
 #include <wstdisplay/scenegraph/drawable.hpp>
 #include <wstdisplay/shader_program.hpp>
 
@@ -31,10 +35,21 @@ class VertexArrayDrawable : public Drawable
 {
 public:
   VertexArrayDrawable();
-  VertexArrayDrawable(geom::fpoint const& pos, float z_pos, glm::mat4 const& modelview);
+  VertexArrayDrawable(geom::fpoint const& pos, float z_pos, glm::mat4 const& modelview,
+                      std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
   void render(GraphicsContext& gc, unsigned int mask = ~0u) override;
 
+  bool get_batch_state(BatchState& state) const override;
+  void append_to_batch(VertexArrayDrawable& batch) const override;
+
+  /** Start a primitive given as \a mode, the vertices added until
+      end() get connected by indices as set_mode()'s GL_TRIANGLES or
+      GL_LINES list. This way fans, strips and loops can share one
+      draw. Once used, all vertices have to be added this way. */
+  void begin(GLenum mode);
+  void end();
+
   void normal(float x, float y, float z);
 
   void vertex(int x, int y, int z = 0);
@@ -43,19 +58,36 @@ public:
 
   void texcoord(float u, float v);
   void color(surf::Color const& color);
+  void color(RGBA8 color);
 
   void add_vertices(std::span<float const> data);
   void add_texcoords(std::span<float const> data);
   void add_normals(std::span<float const> data);
-  void add_indices(std::span<unsigned short int const> data);
+
+  /** Indices are relative to the first vertex, the index type used
+      for drawing is picked from the largest index */
+  void add_indices(std::span<uint16_t const> data);
+  void add_indices(std::span<uint32_t const> data);
 
   /** Add eight texcoords for use with a quad from a given rect. The
       coords are clockwise around the rect, ie: left, top, right, top,
       right, bottom, left, bottom */
   void add_texcoords_from_rect(geom::frect const& coords);
 
+  /** Append two triangles per rect, for use with GL_TRIANGLES */
+  void add_rects(std::span<RectColor const> rects);
+
+  /** Append two vertices per line, for use with GL_LINES */
+  void add_lines(std::span<LineColor const> lines);
+
+  /** Reserve space for \a count more vertices */
+  void reserve(int count, bool texcoords = false);
+
   int num_vertices() const;
 
+  /** Multiply all vertices starting at \a first_vertex with \a matrix */
+  void transform(int first_vertex, glm::mat4 const& matrix);
+
   void clear();
 
   void set_program(ShaderProgramPtr program);
@@ -65,6 +97,18 @@ public:
   void set_blend_func(GLenum sfactor, GLenum dfactor);
   void set_depth_test(bool depth_test);
 
+  /** Store colors as floats, so that values above 1.0 reach the
+      shader. Must be set before the first color() call, HDR drawables
+      are not batched. */
+  void set_hdr(bool hdr);
+
+  /** Keep the geometry in a vertex buffer owned by the drawable. It
+      is uploaded on the first render() after a modification, later
+      renders only bind and draw it. Static drawables are not
+      batched. */
+  void set_static(bool value);
+  bool is_static() const { return m_static; }
+
 private:
   ShaderProgramPtr m_program;
   GLenum m_mode;
@@ -73,13 +117,26 @@ private:
   GLenum m_blend_dfactor;
 
   bool m_depth_test;
-
-  std::unordered_map<int, TexturePtr> m_textures;
-  std::vector<float> m_colors;
-  std::vector<float> m_texcoords;
-  std::vector<float> m_normals;
-  std::vector<float> m_vertices;
-  std::vector<unsigned short int> m_indices;
+  bool m_hdr;
+
+  bool m_static;
+  bool m_dirty;
+  std::unique_ptr<GLVertexArrays> m_static_va;
+  GLint m_static_first;
+  GLintptr m_static_indices_offset;
+
+  std::array<TexturePtr, 4> m_textures;
+  std::pmr::vector<RGBA8> m_colors;
+  std::pmr::vector<float> m_hdr_colors;
+  std::pmr::vector<float> m_texcoords;
+  std::pmr::vector<float> m_normals;
+  std::pmr::vector<float> m_vertices;
+  std::pmr::vector<uint32_t> m_indices;
+  uint32_t m_max_index;
+
+  /** State between begin() and end() */
+  GLenum m_primitive_mode;
+  int m_primitive_first;
 };
 
 } // namespace wstdisplay
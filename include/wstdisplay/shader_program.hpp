@@ -19,7 +19,10 @@
 
 #include <GL/glew.h>
 #include <memory>
+#include <stdint.h>
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include "shader_object.hpp"
 
@@ -29,6 +32,35 @@ class ShaderObject;
 class ShaderProgram;
 using ShaderProgramPtr = std::shared_ptr<ShaderProgram>;
 
+/** Name of a uniform or attribute along with its hash, the hash of
+    string literals is computed at compile time when the ShaderName is
+    constexpr */
+class ShaderName
+{
+public:
+  constexpr ShaderName(const char* name) :
+    m_name(name),
+    m_hash(hash(name))
+  {}
+
+  constexpr const char* get_name() const { return m_name; }
+  constexpr uint32_t get_hash() const { return m_hash; }
+
+  /** FNV-1a */
+  static constexpr uint32_t hash(std::string_view text)
+  {
+    uint32_t result = 2166136261u;
+    for (char c : text) {
+      result = (result ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return result;
+  }
+
+private:
+  const char* m_name;
+  uint32_t m_hash;
+};
+
 class ShaderProgram
 {
 public:
@@ -50,26 +82,44 @@ public:
   std::string get_info_log() const;
   bool get_link_status() const;
 
-  GLint get_uniform_location(const char* name) const;
-  GLint get_attrib_location(const char* name) const;
+  /** Locations are looked up in a cache filled by link(), names
+      that don't exist are reported once and return -1 */
+  GLint get_uniform_location(ShaderName const& name) const;
+  GLint get_attrib_location(ShaderName const& name) const;
   GLuint get_handle() const;
 
   // FIXME: All these only work when you call
   // glUseProgram(shader_program.get_handle()); before them
-  void set_uniform1f(const char* name, GLfloat v0);
-  void set_uniform2f(const char* name, GLfloat v0, GLfloat v1);
-  void set_uniform3f(const char* name, GLfloat v0, GLfloat v1, GLfloat v2);
-  void set_uniform4f(const char* name, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
+  void set_uniform1f(ShaderName const& name, GLfloat v0);
+  void set_uniform2f(ShaderName const& name, GLfloat v0, GLfloat v1);
+  void set_uniform3f(ShaderName const& name, GLfloat v0, GLfloat v1, GLfloat v2);
+  void set_uniform4f(ShaderName const& name, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
 
-  void set_uniform1i(const char* name, GLint v0);
-  void set_uniform2i(const char* name, GLint v0, GLint v1);
-  void set_uniform3i(const char* name, GLint v0, GLint v1, GLint v2);
-  void set_uniform4i(const char* name, GLint v0, GLint v1, GLint v2, GLint v3);
+  void set_uniform1i(ShaderName const& name, GLint v0);
+  void set_uniform2i(ShaderName const& name, GLint v0, GLint v1);
+  void set_uniform3i(ShaderName const& name, GLint v0, GLint v1, GLint v2);
+  void set_uniform4i(ShaderName const& name, GLint v0, GLint v1, GLint v2, GLint v3);
 
   void bind_frag_data_location(GLuint color_number, const char* name);
 
+private:
+  struct Location
+  {
+    uint32_t hash;
+    std::string name;
+    GLint location;
+  };
+
+  void update_locations();
+  GLint lookup(std::vector<Location>& cache, ShaderName const& name, const char* kind) const;
+
 private:
   GLuint m_handle;
+
+  /** Active uniforms and attributes, names that failed to resolve
+      get appended with a location of -1 */
+  mutable std::vector<Location> m_uniforms;
+  mutable std::vector<Location> m_attribs;
 };
 
 } // namespace wstdisplay
@@ -0,0 +1,145 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HEADER_WINDSTILLE_DISPLAY_SHAPE_RENDERER_HPP
+#define HEADER_WINDSTILLE_DISPLAY_SHAPE_RENDERER_HPP
+
+#include <span>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <geom/point.hpp>
+#include <geom/rect.hpp>
+#include <surf/color.hpp>
+
+#include "gl_vertex_arrays.hpp"
+#include "shader_program.hpp"
+
+namespace wstdisplay {
+
+class GLStateTracker;
+class GraphicsContext;
+
+enum class ShapeType : uint32_t
+{
+  CIRCLE = 0,
+  ARC = 1,
+  ROUNDED_RECT = 2,
+  CAPSULE = 3
+};
+
+/** A shape that is drawn as a single quad, its outline is evaluated
+    as signed distance in the fragment shader and anti-aliased */
+struct Shape
+{
+  ShapeType type = ShapeType::CIRCLE;
+
+  /** center */
+  float x = 0.0f;
+  float y = 0.0f;
+
+  /** half the size, for circles and arcs the radius */
+  float half_width = 0.0f;
+  float half_height = 0.0f;
+
+  /** corner radius of ROUNDED_RECT */
+  float radius = 0.0f;
+
+  /** 0 for a filled shape, otherwise the width of the outline, which
+      is centered on the edge */
+  float stroke = 0.0f;
+
+  /** angles of ARC in degrees */
+  float start = 0.0f;
+  float end = 0.0f;
+
+  surf::Color color;
+
+  /** A circle, or with \a stroke a ring */
+  static Shape circle(geom::fpoint const& pos, float radius, surf::Color const& color, float stroke = 0.0f);
+
+  /** A pie slice from \a start to \a end degrees */
+  static Shape arc(geom::fpoint const& pos, float radius, float start, float end,
+                   surf::Color const& color, float stroke = 0.0f);
+
+  static Shape rounded_rect(geom::frect const& rect, float radius, surf::Color const& color, float stroke = 0.0f);
+
+  /** A rect with fully rounded short sides */
+  static Shape capsule(geom::frect const& rect, surf::Color const& color, float stroke = 0.0f);
+};
+
+/** Per-instance data of a Shape as it is streamed to the GPU */
+struct ShapeInstance
+{
+  float x, y;
+  float half_width, half_height;
+
+  float radius, stroke;
+
+  /** in radians */
+  float start, end;
+
+  RGBA8 color;
+  uint32_t type;
+};
+
+static_assert(sizeof(ShapeInstance) == 40);
+
+/** Collects shapes and draws them with a single instanced draw call */
+class ShapeRenderer final
+{
+public:
+  ShapeRenderer(GLStateTracker& state, size_t capacity = 256 * 1024);
+  ~ShapeRenderer();
+
+  /** Queue \a shapes under the current projection and modelview,
+      shapes queued under a different matrix get drawn first */
+  void add(GraphicsContext& gc, std::span<Shape const> shapes);
+
+  /** Draw all queued shapes */
+  void flush(GraphicsContext& gc);
+
+  bool empty() const { return m_instances.empty(); }
+
+private:
+  /** Copy the queued instances into the ring buffer, returns the byte offset */
+  size_t upload();
+
+private:
+  ShaderProgramPtr m_program;
+  GLuint m_vao;
+  GLuint m_buffer;
+  size_t m_capacity;
+  size_t m_offset;
+
+  std::vector<ShapeInstance> m_instances;
+  glm::mat4 m_modelviewprojection;
+
+private:
+  ShapeRenderer(const ShapeRenderer&) = delete;
+  ShapeRenderer& operator=(const ShapeRenderer&) = delete;
+};
+
+} // namespace wstdisplay
+
+#endif
+
+/* EOF */
@@ -0,0 +1,87 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HEADER_WINDSTILLE_DISPLAY_SPRITE_RENDERER_HPP
+#define HEADER_WINDSTILLE_DISPLAY_SPRITE_RENDERER_HPP
+
+#include <span>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <GL/glew.h>
+
+#include "shader_program.hpp"
+#include "surface.hpp"
+
+namespace wstdisplay {
+
+class GLStateTracker;
+class GraphicsContext;
+class SurfaceDrawingParameters;
+
+/** Per-instance data of a sprite, the vertex shader expands it into a
+    rotated quad. Flipping is done by swapping the uv coordinates. */
+struct SpriteInstance
+{
+  float x, y;
+  float width, height;
+
+  /** rotation around the center in degrees */
+  float angle;
+
+  /** uv rect, normalized to [0, 65535] */
+  uint16_t u1, v1, u2, v2;
+
+  uint8_t r, g, b, a;
+};
+
+static_assert(sizeof(SpriteInstance) == 32);
+
+/** Draws many copies of a Surface with a single instanced draw call */
+class SpriteRenderer final
+{
+public:
+  SpriteRenderer(GLStateTracker& state, size_t capacity = 1024 * 1024);
+  ~SpriteRenderer();
+
+  /** Draw \a surface once for every element of \a params. Blend func
+      and depth test are taken from the first element, z_pos is
+      ignored. */
+  void draw(GraphicsContext& gc, SurfacePtr const& surface,
+            std::span<SurfaceDrawingParameters const> params);
+
+private:
+  /** Copy the instances into the ring buffer, returns the byte offset */
+  size_t upload(SurfacePtr const& surface, std::span<SurfaceDrawingParameters const> params);
+
+private:
+  ShaderProgramPtr m_program;
+  GLuint m_vao;
+  GLuint m_buffer;
+  size_t m_capacity;
+  size_t m_offset;
+
+private:
+  SpriteRenderer(const SpriteRenderer&) = delete;
+  SpriteRenderer& operator=(const SpriteRenderer&) = delete;
+};
+
+} // namespace wstdisplay
+
+#endif
+
+/* EOF */
@@ -0,0 +1,101 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HEADER_WINDSTILLE_DISPLAY_STROKER_HPP
+#define HEADER_WINDSTILLE_DISPLAY_STROKER_HPP
+
+#include <optional>
+#include <span>
+#include <stdint.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gl_vertex_arrays.hpp"
+
+namespace wstdisplay {
+
+class VertexArrayDrawable;
+
+enum class LineJoin { MITER, BEVEL, ROUND };
+enum class LineCap { BUTT, SQUARE, ROUND };
+
+struct StrokeStyle
+{
+  float width = 1.0f;
+  LineJoin join = LineJoin::MITER;
+  LineCap cap = LineCap::BUTT;
+
+  /** Miter joins whose length, measured from the inner to the outer
+      corner, exceeds miter_limit * width become bevels, the same
+      ratio as SVG's stroke-miterlimit */
+  float miter_limit = 4.0f;
+};
+
+/** Expands polylines into triangles, so that lines of any width look
+    the same on every driver and batch with filled shapes. Segments
+    meet at the inner corner of a join, except when the join is so
+    sharp that the corner would cut deeper than half a segment, then
+    the segments overlap there and translucent lines get darker. */
+class Stroker final
+{
+public:
+  Stroker();
+
+  /** Add the outline of \a points, \a closed connects the last point
+      with the first and leaves out the caps */
+  void stroke(std::span<glm::vec2 const> points, bool closed, StrokeStyle const& style);
+
+  /** Append the triangles collected so far to \a va, which has to be
+      in GL_TRIANGLES mode and only hold indexed geometry */
+  void append(VertexArrayDrawable& va, RGBA8 color) const;
+
+  void clear();
+
+  std::span<glm::vec2 const> get_vertices() const { return m_vertices; }
+  std::span<uint32_t const> get_indices() const { return m_indices; }
+
+private:
+  /** \a a_inner and \a b_inner replace the inner corner at either end */
+  void add_quad(glm::vec2 const& a, glm::vec2 const& b, float half_width,
+                std::optional<glm::vec2> const& a_inner, std::optional<glm::vec2> const& b_inner);
+  void add_join(glm::vec2 const& p, glm::vec2 const& d0, glm::vec2 const& d1, StrokeStyle const& style,
+                std::optional<glm::vec2> const& inner);
+  void add_cap(glm::vec2 const& p, glm::vec2 const& d, StrokeStyle const& style);
+
+  /** Fan around \a center starting at \a from, turning by \a angle radians */
+  void add_round(glm::vec2 const& center, glm::vec2 const& from, float angle, float half_width);
+
+  uint32_t add_vertex(glm::vec2 const& v);
+
+private:
+  std::vector<glm::vec2> m_points;
+  std::vector<std::optional<glm::vec2>> m_inner;
+  std::vector<glm::vec2> m_vertices;
+  std::vector<uint32_t> m_indices;
+  mutable std::vector<uint32_t> m_rebased;
+
+private:
+  Stroker(const Stroker&) = delete;
+  Stroker& operator=(const Stroker&) = delete;
+};
+
+} // namespace wstdisplay
+
+#endif
+
+/* EOF */
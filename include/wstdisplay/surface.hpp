@@ -26,6 +26,7 @@ namespace wstdisplay {
 class GraphicsContext;
 class SurfaceDrawingParameters;
 class Surface;
+class VertexArrayDrawable;
 
 using SurfacePtr = std::shared_ptr<Surface>;
 
@@ -65,11 +66,20 @@ public:
   /** Returns texture coordinates for the Surface rectangle */
   geom::frect get_uv() const;
 
+  /** Point the Surface at a new location of its pixels, used when
+      TexturePacker moves it. Drawables that are already queued keep
+      the old location, so only call this between frames. */
+  void relocate(TexturePtr texture, const geom::frect& uv);
+
   void draw(GraphicsContext& gc, geom::fpoint const& pos) const;
   void draw(GraphicsContext& gc, geom::frect const& dstrect) const;
   void draw(GraphicsContext& gc, geom::frect const& srcrect, geom::frect const& dstrect) const;
   void draw(GraphicsContext& gc, SurfaceDrawingParameters const& params) const;
 
+  /** Append the Surface as two triangles to \a va, blend func and
+      depth test of \a params are left to the caller */
+  void append(VertexArrayDrawable& va, SurfaceDrawingParameters const& params) const;
+
 private:
   /** Texture on which the surface is located */
   TexturePtr m_texture;
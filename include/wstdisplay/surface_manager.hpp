@@ -19,6 +19,7 @@
 
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -27,11 +28,25 @@
 
 namespace wstdisplay {
 
+class AtlasFile;
 class TexturePacker;
 
 /** This class keeps a list of loaded surfaces and manages loading new ones */
 class SurfaceManager final
 {
+public:
+  struct AtlasOptions
+  {
+    /** size of the shared textures */
+    geom::isize page_size = geom::isize(2048, 2048);
+
+    /** surfaces wider or higher than this get a texture of their own */
+    int max_surface_size = 256;
+
+    /** pixels of repeated edge around each surface */
+    int padding = 1;
+  };
+
 public:
   SurfaceManager();
   ~SurfaceManager();
@@ -47,13 +62,36 @@ public:
   TexturePtr create_texture(SoftwareSurface const& image,
                             float* maxu, float* maxv);
 
-  /** Removes all cached Sprites that are no longer in use */
+  /** Pack small surfaces loaded from now on into shared textures,
+      so that different sprites can be drawn in the same batch */
+  void set_atlas(AtlasOptions const& options);
+  bool has_atlas() const { return m_atlas.has_value(); }
+
+  /** Upload the pages of an atlas baked with wstdisplay-atlasbake,
+      get() then answers the names in its index without decoding
+      any image */
+  void load_atlas(std::filesystem::path const& filename);
+
+  /** Removes all cached Sprites that are no longer in use and
+      returns their space in the atlas for reuse */
   void cleanup();
 
+  /** Incrementally move packed surfaces off the emptiest atlas page,
+      see TexturePacker::defragment(), call between frames */
+  int defragment(int max_moves = 64);
+
   void save_all_as_png() const;
 
 private:
   std::unique_ptr<TexturePacker> m_texture_packer;
+  std::optional<AtlasOptions> m_atlas;
+
+  struct LoadedAtlas
+  {
+    std::unique_ptr<AtlasFile> file;
+    std::vector<TexturePtr> pages;
+  };
+  std::vector<LoadedAtlas> m_atlas_files;
   std::map<std::filesystem::path, SurfacePtr> m_surfaces;
 };
 
@@ -68,6 +68,14 @@ public:
       coordinates */
   void put(SoftwareSurface const& image, const geom::irect& srcrect, int x, int y);
 
+  /** Uploads tightly packed RGBA8 \a pixels of the given size to
+      the given coordinates */
+  void put(void const* pixels, geom::isize const& size, int x, int y);
+
+  /** Copies \a srcrect of \a source to the given coordinates on
+      the GPU */
+  void copy(Texture const& source, const geom::irect& srcrect, int x, int y);
+
   GLuint get_handle() const;
 
   /**
@@ -17,6 +17,7 @@
 #ifndef HEADER_WINDSTILLE_DISPLAY_TEXTURE_PACKER_HPP
 #define HEADER_WINDSTILLE_DISPLAY_TEXTURE_PACKER_HPP
 
+#include <span>
 #include <vector>
 
 #include <geom/rect.hpp>
@@ -35,15 +36,49 @@ class TexturePacker
 private:
   using Textures = std::vector<TexturePackerTexture*>;
   geom::isize     texture_size;
+  int             padding;
   Textures textures;
 
 public:
-  TexturePacker(const geom::isize& texture_size);
+  struct PageInfo
+  {
+    TexturePtr texture;
+
+    /** number of surfaces on the page */
+    int count;
+
+    /** fraction of the page that is allocated, borders included */
+    float occupancy;
+  };
+
+public:
+  /** \a padding is the number of pixels the edges of each surface
+      get repeated, so that filtering doesn't pick up the neighbours */
+  TexturePacker(const geom::isize& texture_size, int padding = 1);
   ~TexturePacker();
 
   SurfacePtr upload(SoftwareSurface const& surface);
+
+  /** Upload all \a surfaces, sorted by height for a denser packing,
+      the result is in the order of \a surfaces */
+  std::vector<SurfacePtr> upload(std::span<SoftwareSurface const> surfaces);
+
   bool allocate(const geom::isize& size, geom::irect& rect, TexturePtr& out_texture);
 
+  /** Return the space of surfaces that are no longer referenced
+      anywhere, pages that become empty are released. Returns the
+      number of freed regions. */
+  int collect();
+
+  /** Move up to \a max_moves surfaces off the emptiest page onto the
+      others, with copies on the GPU, so that it can be released. The
+      surfaces are relocated in place, so only call this between
+      frames. Returns the number of moved surfaces. */
+  int defragment(int max_moves = 64);
+
+  /** Occupancy of every texture page, for measuring the packing */
+  std::vector<PageInfo> get_page_info() const;
+
   void save_all_as_png() const;
 
 private:
@@ -18,8 +18,13 @@
 
 #include <stdexcept>
 #include <sstream>
+#include <string_view>
 #include <GL/glew.h>
 
+#include <logmich/log.hpp>
+
+bool g_assert_gl_enabled = true;
+
 void assert_gl_loc(char const* file, int line, char const* message)
 {
   GLenum error = glGetError();
@@ -32,4 +37,85 @@ void assert_gl_loc(char const* file, int line, char const* message)
   }
 }
 
+namespace wstdisplay {
+
+namespace {
+
+bool g_debug_callback_installed = false;
+thread_local GLDebugScope const* g_current_scope = nullptr;
+
+void GLAPIENTRY
+debug_message_callback(GLenum /*source*/, GLenum type, GLuint id, GLenum severity,
+                       GLsizei length, GLchar const* message, void const* /*user_param*/)
+{
+  std::ostringstream location;
+  if (GLDebugScope const* scope = GLDebugScope::current()) {
+    location << scope->get_file() << ":" << scope->get_line() << ": " << scope->get_name();
+  } else {
+    location << "<no scope>";
+  }
+
+  if (type == GL_DEBUG_TYPE_ERROR) {
+    log_error("{}: OpenGL error {}: {}", location.str(), id, std::string_view(message, length));
+  } else if (severity == GL_DEBUG_SEVERITY_HIGH || severity == GL_DEBUG_SEVERITY_MEDIUM) {
+    log_warn("{}: OpenGL {}: {}", location.str(), id, std::string_view(message, length));
+  } else {
+    log_debug("{}: OpenGL {}: {}", location.str(), id, std::string_view(message, length));
+  }
+}
+
+} // namespace
+
+bool
+install_gl_debug_callback()
+{
+  if (!GLEW_KHR_debug) {
+    log_info("GL_KHR_debug not available, falling back to glGetError()");
+    return false;
+  }
+
+  glEnable(GL_DEBUG_OUTPUT);
+  // report messages from within the offending call, so that the
+  // current GLDebugScope is still the right one
+  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  glDebugMessageCallback(&debug_message_callback, nullptr);
+  glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+
+  g_debug_callback_installed = true;
+  g_assert_gl_enabled = false;
+
+  return true;
+}
+
+GLDebugScope::GLDebugScope(char const* name, char const* file, int line) :
+  m_name(name),
+  m_file(file),
+  m_line(line),
+  m_parent(g_current_scope),
+  m_group_pushed(g_debug_callback_installed)
+{
+  g_current_scope = this;
+
+  if (m_group_pushed) {
+    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, m_name);
+  }
+}
+
+GLDebugScope::~GLDebugScope()
+{
+  if (m_group_pushed) {
+    glPopDebugGroup();
+  }
+
+  g_current_scope = m_parent;
+}
+
+GLDebugScope const*
+GLDebugScope::current()
+{
+  return g_current_scope;
+}
+
+} // namespace wstdisplay
+
 /* EOF */
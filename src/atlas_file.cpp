@@ -0,0 +1,366 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "atlas_file.hpp"
+
+#include <algorithm>
+#include <assert.h>
+#include <limits.h>
+#include <bit>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string.h>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#include "blitter.hpp"
+#include "rect_packer.hpp"
+
+namespace wstdisplay {
+
+namespace {
+
+constexpr uint64_t align16(uint64_t value)
+{
+  return (value + 15) & ~uint64_t(15);
+}
+
+std::runtime_error atlas_error(std::filesystem::path const& filename, std::string_view message)
+{
+  std::ostringstream msg;
+  msg << filename << ": " << message;
+  return std::runtime_error(msg.str());
+}
+
+} // namespace
+
+AtlasBuilder::AtlasBuilder(geom::isize const& page_size, int padding) :
+  m_page_size(page_size),
+  m_padding(std::max(padding, 0)),
+  m_images(),
+  m_occupancy()
+{
+}
+
+void
+AtlasBuilder::add(std::string name, SoftwareSurface surface)
+{
+  m_images.push_back(Image{std::move(name), std::move(surface)});
+}
+
+void
+AtlasBuilder::write(std::filesystem::path const& filename)
+{
+  if constexpr (std::endian::native != std::endian::little) {
+    throw atlas_error(filename, "atlas files can only be written on little endian machines");
+  }
+
+  // tall images first, like TexturePacker::upload()
+  std::vector<size_t> order(m_images.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs) {
+    return m_images[lhs].surface.get_height() > m_images[rhs].surface.get_height();
+  });
+
+  std::vector<std::unique_ptr<RectPacker>> packers;
+  std::vector<SoftwareSurface> pages;
+  std::vector<AtlasFileEntry> entries(m_images.size());
+
+  for (size_t idx : order)
+  {
+    Image const& image = m_images[idx];
+    int const w = image.surface.get_width();
+    int const h = image.surface.get_height();
+    geom::isize const size(w + 2 * m_padding, h + 2 * m_padding);
+
+    std::optional<geom::irect> rect;
+    size_t page = 0;
+    for (; page < packers.size() && !rect; ++page) {
+      rect = packers[page]->insert(size);
+    }
+
+    if (!rect) {
+      packers.push_back(std::make_unique<RectPacker>(m_page_size));
+      pages.push_back(SoftwareSurface::create(surf::PixelFormat::RGBA8, m_page_size, surf::Color(0.0f, 0.0f, 0.0f, 0.0f)));
+      rect = packers.back()->insert(size);
+      page = packers.size();
+      if (!rect) {
+        throw atlas_error(image.name, "image is larger than an atlas page");
+      }
+    }
+    page -= 1;
+
+    int const x = rect->left() + m_padding;
+    int const y = rect->top() + m_padding;
+    blit_with_border(image.surface, pages[page], x, y, m_padding);
+
+    AtlasFileEntry& entry = entries[idx];
+    entry.page = static_cast<uint32_t>(page);
+    entry.u1 = static_cast<float>(x)     / static_cast<float>(m_page_size.width());
+    entry.v1 = static_cast<float>(y)     / static_cast<float>(m_page_size.height());
+    entry.u2 = static_cast<float>(x + w) / static_cast<float>(m_page_size.width());
+    entry.v2 = static_cast<float>(y + h) / static_cast<float>(m_page_size.height());
+    entry.width = static_cast<float>(w);
+    entry.height = static_cast<float>(h);
+  }
+
+  // sorted index, so that lookups can be a binary search
+  std::vector<size_t> by_name(m_images.size());
+  std::iota(by_name.begin(), by_name.end(), 0);
+  std::sort(by_name.begin(), by_name.end(), [this](size_t lhs, size_t rhs) {
+    return m_images[lhs].name < m_images[rhs].name;
+  });
+
+  std::string names;
+  std::vector<AtlasFileEntry> sorted_entries;
+  sorted_entries.reserve(entries.size());
+  for (size_t i = 0; i < by_name.size(); ++i)
+  {
+    std::string const& name = m_images[by_name[i]].name;
+    if (i > 0 && name == m_images[by_name[i - 1]].name) {
+      throw atlas_error(filename, "duplicate name " + name);
+    }
+
+    AtlasFileEntry entry = entries[by_name[i]];
+    entry.name_offset = static_cast<uint32_t>(names.size());
+    entry.name_length = static_cast<uint32_t>(name.size());
+    names += name;
+    sorted_entries.push_back(entry);
+  }
+
+  AtlasFileHeader header;
+  memcpy(header.magic, AtlasFileHeader::MAGIC, sizeof(header.magic));
+  header.version = AtlasFileHeader::VERSION;
+  header.page_count = static_cast<uint32_t>(pages.size());
+  header.page_width = static_cast<uint32_t>(m_page_size.width());
+  header.page_height = static_cast<uint32_t>(m_page_size.height());
+  header.entry_count = static_cast<uint32_t>(sorted_entries.size());
+  header.names_size = static_cast<uint32_t>(names.size());
+  header.pages_offset = align16(sizeof(AtlasFileHeader) +
+                                sorted_entries.size() * sizeof(AtlasFileEntry) +
+                                names.size());
+
+  std::ofstream out(filename, std::ios::binary);
+  if (!out) {
+    throw atlas_error(filename, "couldn't open file for writing");
+  }
+
+  out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  out.write(reinterpret_cast<char const*>(sorted_entries.data()),
+            static_cast<std::streamsize>(sorted_entries.size() * sizeof(AtlasFileEntry)));
+  out.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+  while (static_cast<uint64_t>(out.tellp()) < header.pages_offset) {
+    out.put('\0');
+  }
+
+  m_occupancy.clear();
+  for (size_t page = 0; page < pages.size(); ++page)
+  {
+    // rows might be padded in the surface, but not in the file
+    uint8_t const* data = static_cast<uint8_t const*>(pages[page].get_data());
+    for (int y = 0; y < m_page_size.height(); ++y) {
+      out.write(reinterpret_cast<char const*>(data + y * pages[page].get_pitch()),
+                static_cast<std::streamsize>(m_page_size.width()) * 4);
+    }
+
+    m_occupancy.push_back(packers[page]->get_occupancy());
+  }
+
+  if (!out) {
+    throw atlas_error(filename, "write failed");
+  }
+}
+
+std::vector<float>
+AtlasBuilder::get_occupancy() const
+{
+  return m_occupancy;
+}
+
+AtlasFile::AtlasFile(std::filesystem::path const& filename) :
+  m_data(nullptr),
+  m_size(0),
+  m_buffer(),
+  m_header(nullptr),
+  m_entries(),
+  m_names(nullptr)
+{
+  if constexpr (std::endian::native != std::endian::little) {
+    throw atlas_error(filename, "atlas files can only be read on little endian machines");
+  }
+
+#ifndef _WIN32
+  int const fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw atlas_error(filename, "couldn't open file");
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(AtlasFileHeader))) {
+    ::close(fd);
+    throw atlas_error(filename, "not an atlas file");
+  }
+
+  m_size = static_cast<size_t>(st.st_size);
+  void* const addr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+
+  if (addr == MAP_FAILED) {
+    throw atlas_error(filename, "mmap() failed");
+  }
+  m_data = static_cast<uint8_t const*>(addr);
+#else
+  std::ifstream in(filename, std::ios::binary);
+  m_buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  m_data = m_buffer.data();
+  m_size = m_buffer.size();
+#endif
+
+  try {
+    validate(filename);
+  } catch (...) {
+    unmap();
+    throw;
+  }
+}
+
+void
+AtlasFile::validate(std::filesystem::path const& filename)
+{
+  if (m_size < sizeof(AtlasFileHeader)) {
+    throw atlas_error(filename, "not an atlas file");
+  }
+
+  m_header = reinterpret_cast<AtlasFileHeader const*>(m_data);
+  if (memcmp(m_header->magic, AtlasFileHeader::MAGIC, sizeof(m_header->magic)) != 0) {
+    throw atlas_error(filename, "not an atlas file");
+  }
+
+  if (m_header->version != AtlasFileHeader::VERSION) {
+    throw atlas_error(filename, "unsupported atlas version");
+  }
+
+  if (m_header->page_width == 0 || m_header->page_width > INT_MAX ||
+      m_header->page_height == 0 || m_header->page_height > INT_MAX ||
+      m_header->page_count > INT_MAX) {
+    throw atlas_error(filename, "invalid atlas page size");
+  }
+
+  // every term is bounded before the next multiplication, so none of
+  // them can overflow
+  uint64_t const entries_end = sizeof(AtlasFileHeader) + uint64_t(m_header->entry_count) * sizeof(AtlasFileEntry);
+  uint64_t const names_end = entries_end + m_header->names_size;
+  uint64_t const page_pixels = uint64_t(m_header->page_width) * m_header->page_height;
+  if (names_end > m_header->pages_offset ||
+      m_header->pages_offset > m_size ||
+      page_pixels > (m_size - m_header->pages_offset) / 4 ||
+      m_header->page_count > (m_size - m_header->pages_offset) / (page_pixels * 4)) {
+    throw atlas_error(filename, "truncated atlas file");
+  }
+
+  m_entries = std::span<AtlasFileEntry const>(
+    reinterpret_cast<AtlasFileEntry const*>(m_data + sizeof(AtlasFileHeader)),
+    m_header->entry_count);
+  m_names = reinterpret_cast<char const*>(m_data + entries_end);
+
+  for (AtlasFileEntry const& entry : m_entries) {
+    if (uint64_t(entry.name_offset) + entry.name_length > m_header->names_size ||
+        entry.page >= m_header->page_count) {
+      throw atlas_error(filename, "corrupt atlas index");
+    }
+  }
+
+  // find() does a binary search
+  if (!std::is_sorted(m_entries.begin(), m_entries.end(),
+                      [this](AtlasFileEntry const& lhs, AtlasFileEntry const& rhs) {
+                        return get_name(lhs) < get_name(rhs);
+                      })) {
+    throw atlas_error(filename, "atlas index not sorted");
+  }
+}
+
+AtlasFile::~AtlasFile()
+{
+  unmap();
+}
+
+void
+AtlasFile::unmap()
+{
+#ifndef _WIN32
+  if (m_data) {
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+  }
+#endif
+  m_data = nullptr;
+  m_size = 0;
+}
+
+geom::isize
+AtlasFile::get_page_size() const
+{
+  return geom::isize(static_cast<int>(m_header->page_width),
+                     static_cast<int>(m_header->page_height));
+}
+
+int
+AtlasFile::get_page_count() const
+{
+  return static_cast<int>(m_header->page_count);
+}
+
+void const*
+AtlasFile::get_page_data(int page) const
+{
+  assert(page >= 0 && page < get_page_count());
+  uint64_t const page_bytes = uint64_t(m_header->page_width) * m_header->page_height * 4;
+  return m_data + m_header->pages_offset + page_bytes * static_cast<uint64_t>(page);
+}
+
+std::string_view
+AtlasFile::get_name(AtlasFileEntry const& entry) const
+{
+  return std::string_view(m_names + entry.name_offset, entry.name_length);
+}
+
+AtlasFileEntry const*
+AtlasFile::find(std::string_view name) const
+{
+  auto it = std::lower_bound(m_entries.begin(), m_entries.end(), name,
+                             [this](AtlasFileEntry const& entry, std::string_view value) {
+                               return get_name(entry) < value;
+                             });
+  if (it != m_entries.end() && get_name(*it) == name) {
+    return &*it;
+  } else {
+    return nullptr;
+  }
+}
+
+} // namespace wstdisplay
+
+/* EOF */
@@ -16,7 +16,9 @@
 
 #include "blitter.hpp"
 
+#include <algorithm>
 #include <assert.h>
+#include <stdexcept>
 #include <stdint.h>
 #include <string.h>
 
@@ -52,6 +54,67 @@ void generate_border(SoftwareSurface& surface,
   }
 }
 
+void blit_with_border(SoftwareSurface const& src, SoftwareSurface& dst,
+                      int x_pos, int y_pos, int border)
+{
+  // src comes straight from image files, so check it in release builds too
+  if (dst.get_format() != surf::PixelFormat::RGBA8 ||
+      (src.get_format() != surf::PixelFormat::RGBA8 &&
+       src.get_format() != surf::PixelFormat::RGB8)) {
+    throw std::runtime_error("blit_with_border: SoftwareSurface format not supported");
+  }
+  assert(x_pos >= border && y_pos >= border &&
+         x_pos + src.get_width() + border <= dst.get_width() &&
+         y_pos + src.get_height() + border <= dst.get_height());
+
+  int const width = src.get_width();
+  int const height = src.get_height();
+
+  if (width == 0 || height == 0) {
+    return;
+  }
+
+  uint8_t const* src_data = static_cast<uint8_t const*>(src.get_data());
+  int const src_pitch = src.get_pitch();
+  uint8_t* data = static_cast<uint8_t*>(dst.get_data());
+  int const pitch = dst.get_pitch();
+  bool const rgb = src.get_format() == surf::PixelFormat::RGB8;
+
+  // copy the rows and extend them to the left and right, all loops
+  // are over contiguous memory, so that the compiler can vectorize them
+  for(int y = 0; y < height; ++y)
+  {
+    uint32_t* row = reinterpret_cast<uint32_t*>(data + (y_pos + y)*pitch + 4*x_pos);
+    uint8_t const* src_row = src_data + y*src_pitch;
+
+    if (rgb) {
+      uint8_t* out = reinterpret_cast<uint8_t*>(row);
+      for(int x = 0; x < width; ++x)
+      {
+        out[4*x + 0] = src_row[3*x + 0];
+        out[4*x + 1] = src_row[3*x + 1];
+        out[4*x + 2] = src_row[3*x + 2];
+        out[4*x + 3] = 255;
+      }
+    } else {
+      memcpy(row, src_row, 4*width);
+    }
+
+    std::fill_n(row - border, border, row[0]);
+    std::fill_n(row + width, border, row[width - 1]);
+  }
+
+  // duplicate the extended top and bottom lines
+  int const line = 4*(width + 2*border);
+  uint8_t const* top = data + y_pos*pitch + 4*(x_pos - border);
+  uint8_t const* bottom = data + (y_pos + height - 1)*pitch + 4*(x_pos - border);
+  for(int i = 1; i <= border; ++i)
+  {
+    memcpy(data + (y_pos - i)*pitch + 4*(x_pos - border), top, line);
+    memcpy(data + (y_pos + height - 1 + i)*pitch + 4*(x_pos - border), bottom, line);
+  }
+}
+
 } // namespace wstdisplay
 
 /* EOF */
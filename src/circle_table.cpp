@@ -0,0 +1,97 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "circle_table.hpp"
+
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace wstdisplay {
+
+namespace {
+
+std::vector<glm::vec2> generate_unit_circle(int segments)
+{
+  std::vector<glm::vec2> table(static_cast<size_t>(segments) + 1);
+
+  for (int i = 0; i < segments; ++i) {
+    double const angle = 2.0 * M_PI * static_cast<double>(i) / static_cast<double>(segments);
+    table[static_cast<size_t>(i)] = glm::vec2(static_cast<float>(cos(angle)),
+                                              static_cast<float>(sin(angle)));
+  }
+
+  if (segments % 4 == 0) {
+    int const quarter = segments / 4;
+    table[static_cast<size_t>(0 * quarter)] = glm::vec2( 1.0f,  0.0f);
+    table[static_cast<size_t>(1 * quarter)] = glm::vec2( 0.0f,  1.0f);
+    table[static_cast<size_t>(2 * quarter)] = glm::vec2(-1.0f,  0.0f);
+    table[static_cast<size_t>(3 * quarter)] = glm::vec2( 0.0f, -1.0f);
+  }
+
+  table[static_cast<size_t>(segments)] = table[0];
+
+  return table;
+}
+
+} // namespace
+
+std::span<glm::vec2 const>
+unit_circle(int segments)
+{
+  assert(segments > 0);
+
+  // node based, so the spans handed out survive rehashing
+  static std::unordered_map<int, std::vector<glm::vec2>> s_tables;
+
+  auto it = s_tables.find(segments);
+  if (it == s_tables.end()) {
+    it = s_tables.emplace(segments, generate_unit_circle(segments)).first;
+  }
+
+  return it->second;
+}
+
+std::span<glm::vec2 const>
+quarter_arc(int segments)
+{
+  return unit_circle(segments * 4).first(static_cast<size_t>(segments) + 1);
+}
+
+int
+circle_segments(float screen_radius)
+{
+  constexpr float max_error = 0.25f;
+  constexpr int min_segments = 8;
+  constexpr int max_segments = 256;
+
+  if (!(screen_radius > max_error)) {
+    return min_segments;
+  }
+
+  // the sagitta of a segment spanning the angle a is r * (1 - cos(a/2))
+  float const angle = 2.0f * acosf(1.0f - max_error / screen_radius);
+  int const segments = static_cast<int>(ceilf(2.0f * static_cast<float>(M_PI) / angle));
+
+  return std::clamp((segments + 3) / 4 * 4, min_segments, max_segments);
+}
+
+} // namespace wstdisplay
+
+/* EOF */
@@ -23,7 +23,6 @@
 #include "graphics_context.hpp"
 #include "scene_context.hpp"
 #include "scenegraph/scene_graph.hpp"
-#include "scenegraph/vertex_array_drawable.hpp"
 
 namespace wstdisplay {
 
@@ -44,29 +43,11 @@ Compositor::Compositor(geom::isize const& framebuffer_size,
 void
 Compositor::render_lightmap(GraphicsContext& gc)
 {
-  VertexArrayDrawable va;
-
-  va.set_texture(m_lightmap->get_texture());
-  va.set_blend_func(GL_DST_COLOR, GL_ZERO); // multiply the lightmap with the screen
-
-  float const vw = 1.0f;
-  float const vh = 1.0f;
-
-  va.set_mode(GL_TRIANGLE_FAN);
-
-  va.texcoord(0, vh);
-  va.vertex(0, 0);
-
-  va.texcoord(vw, vh);
-  va.vertex(m_viewport_size.width(), 0);
-
-  va.texcoord(vw, 0);
-  va.vertex(m_viewport_size.width(), m_viewport_size.height());
-
-  va.texcoord(0, 0);
-  va.vertex(0, m_viewport_size.height());
-
-  va.render(gc);
+  // multiply the lightmap with the screen, framebuffer textures are
+  // upside down
+  gc.get_fullscreen_triangle().draw(gc, m_lightmap->get_texture(),
+                                    glm::vec2(0.0f, 1.0f), glm::vec2(1.0f, 0.0f),
+                                    GL_DST_COLOR, GL_ZERO);
 }
 
 void
@@ -154,28 +135,8 @@ Compositor::render(GraphicsContext& gc, SceneContext& sc, SceneGraph* sg, const
   }
 
   { // Render the screen framebuffer to the actual screen
-    VertexArrayDrawable va;
-
-    va.set_texture(m_screen->get_texture() /*, 0*/);
-
-    float const vw = 1.0f;
-    float const vh = 1.0f;
-
-    va.set_mode(GL_TRIANGLE_FAN);
-    {
-      va.texcoord(0, vh);
-      va.vertex(0, 0);
-
-      va.texcoord(vw, vh);
-      va.vertex(m_viewport_size.width(), 0);
-
-      va.texcoord(vw, 0);
-      va.vertex(m_viewport_size.width(), m_viewport_size.height());
-
-      va.texcoord(0, 0);
-      va.vertex(0, m_viewport_size.height());
-    }
-    va.render(gc);
+    gc.get_fullscreen_triangle().draw(gc, m_screen->get_texture(),
+                                      glm::vec2(0.0f, 1.0f), glm::vec2(1.0f, 0.0f));
   }
 
   // Clear all DrawingContexts
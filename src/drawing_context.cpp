@@ -16,11 +16,16 @@
 
 #include "drawing_context.hpp"
 
+#include <array>
+#include <bit>
+#include <optional>
+
 #include <GL/glew.h>
 #include <glm/gtc/type_ptr.hpp>
 
 #include <geom/line.hpp>
 
+#include "assert_gl.hpp"
 #include "compositor.hpp"
 #include "graphics_context.hpp"
 #include "drawing_parameters.hpp"
@@ -30,23 +35,55 @@
 #include "scenegraph/control_drawable.hpp"
 #include "scenegraph/fill_screen_drawable.hpp"
 #include "scenegraph/fill_screen_pattern_drawable.hpp"
+#include "scenegraph/shape_drawable.hpp"
+#include "scenegraph/sprite_drawable.hpp"
 #include "scenegraph/surface_drawable.hpp"
 #include "scenegraph/surface_quad_drawable.hpp"
 #include "scenegraph/vertex_array_drawable.hpp"
-#include "scenegraph/vertex_array_drawable.hpp"
 
 namespace wstdisplay {
 
-struct DrawablesSorter
+namespace {
+
+/** The outlines were GL_LINES drawn with glLineWidth(2.0f) */
+StrokeStyle const outline_style { 2.0f, LineJoin::MITER, LineCap::BUTT };
+
+/** Map a float to an unsigned int that sorts in the same order */
+uint32_t z_sort_bits(float z)
 {
-  bool operator()(std::unique_ptr<Drawable> const& a, std::unique_ptr<Drawable> const& b) {
-    return a->get_z_pos() < b->get_z_pos();
+  uint32_t const bits = std::bit_cast<uint32_t>(z);
+  if (bits & 0x80000000u) {
+    return ~bits;
+  } else {
+    return bits | 0x80000000u;
   }
-};
+}
+
+/** Pack the BatchState into 16 bits: program (4), texture (8),
+    blend func and mode (3), depth test (1). Collisions only weaken
+    the grouping, they don't affect correctness. */
+uint32_t state_sort_bits(BatchState const& state)
+{
+  uint32_t const program = state.program ? (state.program->get_handle() & 0xfu) : 0u;
+  uint32_t const texture = state.texture ? (state.texture->get_handle() & 0xffu) : 0u;
+  uint32_t const blend = (state.blend_sfactor * 31u + state.blend_dfactor * 7u + state.mode) % 8u;
+
+  return (program << 12) | (texture << 4) | (blend << 1) | (state.depth_test ? 1u : 0u);
+}
+
+} // namespace
 
 DrawingContext::DrawingContext() :
+  m_arena(),
   drawingrequests(),
-  modelview_stack()
+  m_sort_entries(),
+  m_sort_scratch(),
+  m_sorted_requests(),
+  modelview_stack(),
+  m_batch(std::make_unique<VertexArrayDrawable>()),
+  m_stats(),
+  m_stroker(),
+  m_stroke_points()
 {
   modelview_stack.push_back(glm::mat4(1.0f));
 }
@@ -59,22 +96,146 @@ DrawingContext::~DrawingContext()
 void
 DrawingContext::render(GraphicsContext& gc)
 {
-  std::stable_sort(drawingrequests.begin(), drawingrequests.end(), DrawablesSorter());
+  GL_DEBUG_SCOPE("DrawingContext::render");
+
+  sort_requests();
+
+  m_stats = Stats();
+  m_stats.requests = static_cast<int>(drawingrequests.size());
+
+  std::optional<BatchState> batch_state;
+
+  auto flush = [&]{
+    if (batch_state) {
+      m_batch->render(gc, ~0u);
+      m_stats.draws += 1;
+      batch_state.reset();
+    }
+  };
 
   for(Drawables::iterator i = drawingrequests.begin(); i != drawingrequests.end(); ++i)
   {
-    (*i)->render(gc, ~0u);
+    BatchState state;
+    if (!(*i)->get_batch_state(state)) {
+      flush();
+      (*i)->render(gc, ~0u);
+      m_stats.draws += 1;
+    } else {
+      if (batch_state && *batch_state == state) {
+        m_stats.merged += 1;
+      } else {
+        flush();
+
+        m_batch->clear();
+        m_batch->set_program(state.program);
+        m_batch->set_mode(state.mode);
+        if (state.texture) {
+          m_batch->set_texture(state.texture);
+        }
+        m_batch->set_blend_func(state.blend_sfactor, state.blend_dfactor);
+        m_batch->set_depth_test(state.depth_test);
+
+        batch_state = state;
+      }
+
+      int const first_vertex = m_batch->num_vertices();
+      (*i)->append_to_batch(*m_batch);
+      m_batch->transform(first_vertex, (*i)->get_modelview());
+    }
   }
+
+  flush();
+}
+
+void
+DrawingContext::sort_requests()
+{
+  size_t const count = drawingrequests.size();
+
+  m_sort_entries.resize(count);
+  m_sort_scratch.resize(count);
+
+  // key is z (32), segment (16), state (16). Drawables that can't be
+  // batched may have any side effect, so they are barriers: each gets
+  // a segment of its own and requests are only grouped by state
+  // within the runs between them, painter's order is kept otherwise.
+  uint32_t segment = 0;
+  for (size_t i = 0; i < count; ++i) {
+    Drawable const& drawable = *drawingrequests[i];
+
+    uint32_t low;
+    BatchState state;
+    if (drawable.get_batch_state(state)) {
+      low = (segment << 16) | state_sort_bits(state);
+    } else {
+      segment += 1;
+      low = segment << 16;
+      segment += 1;
+    }
+
+    m_sort_entries[i].key = (static_cast<uint64_t>(z_sort_bits(drawable.get_z_pos())) << 32) | low;
+    m_sort_entries[i].index = static_cast<uint32_t>(i);
+  }
+
+  // too many barriers to encode, fall back to sorting by z alone
+  if (segment > 0xffff) {
+    for (SortEntry& entry : m_sort_entries) {
+      entry.key &= 0xffffffff00000000u;
+    }
+  }
+
+  // LSD radix sort, 8 bits per pass; every pass is stable, so requests
+  // with equal keys stay in the order they were queued
+  for (int shift = 0; shift < 64; shift += 8)
+  {
+    std::array<size_t, 256> offsets{};
+    for (SortEntry const& entry : m_sort_entries) {
+      offsets[(entry.key >> shift) & 0xff] += 1;
+    }
+
+    // all keys share this byte, nothing to do
+    if (count == 0 || offsets[(m_sort_entries[0].key >> shift) & 0xff] == count) {
+      continue;
+    }
+
+    size_t sum = 0;
+    for (size_t& offset : offsets) {
+      size_t const n = offset;
+      offset = sum;
+      sum += n;
+    }
+
+    for (SortEntry const& entry : m_sort_entries) {
+      m_sort_scratch[offsets[(entry.key >> shift) & 0xff]++] = entry;
+    }
+
+    std::swap(m_sort_entries, m_sort_scratch);
+  }
+
+  m_sorted_requests.clear();
+  m_sorted_requests.reserve(count);
+  for (SortEntry const& entry : m_sort_entries) {
+    m_sorted_requests.push_back(std::move(drawingrequests[entry.index]));
+  }
+  std::swap(drawingrequests, m_sorted_requests);
+  m_sorted_requests.clear();
 }
 
 void
 DrawingContext::clear()
 {
   drawingrequests.clear();
+  m_arena.reset();
 }
 
 void
 DrawingContext::draw(std::unique_ptr<Drawable> request)
+{
+  drawingrequests.push_back(DrawablePtr(request.release()));
+}
+
+void
+DrawingContext::draw(DrawablePtr request)
 {
   drawingrequests.push_back(std::move(request));
 }
@@ -83,15 +244,15 @@ void
 DrawingContext::draw(SurfacePtr surface, const geom::fpoint& pos, const geom::fquad& quad,
                      const DrawingParameters& params, float z_pos)
 {
-  draw(std::make_unique<SurfaceQuadDrawable>(surface, pos, quad, params, z_pos,
-                                             modelview_stack.back()));
+  emplace<SurfaceQuadDrawable>(surface, pos, quad, params, z_pos,
+                               modelview_stack.back());
 }
 
 void
 DrawingContext::draw(SurfacePtr surface, const SurfaceDrawingParameters& params, float z_pos)
 {
-  draw(std::make_unique<SurfaceDrawable>(surface, params, z_pos,
-                                         modelview_stack.back()));
+  emplace<SurfaceDrawable>(surface, params, z_pos,
+                           modelview_stack.back());
 }
 
 void
@@ -103,27 +264,27 @@ DrawingContext::draw(SurfacePtr surface, const geom::fpoint& pos, float z, float
 void
 DrawingContext::draw(SurfacePtr surface, float x, float y, float z, float )
 {
-  draw(std::make_unique<SurfaceDrawable>(surface,
-                                         SurfaceDrawingParameters().set_pos(geom::fpoint(x, y)),
-                                         z, modelview_stack.back()));
+  emplace<SurfaceDrawable>(surface,
+                           SurfaceDrawingParameters().set_pos(geom::fpoint(x, y)),
+                           z, modelview_stack.back());
 }
 
 void
 DrawingContext::draw_control(SurfacePtr surface, const geom::fpoint& pos, float angle, float z_pos)
 {
-  draw(std::make_unique<ControlDrawable>(surface, pos, angle, z_pos, modelview_stack.back()));
+  emplace<ControlDrawable>(surface, pos, angle, z_pos, modelview_stack.back());
 }
 
 void
 DrawingContext::fill_screen(const surf::Color& color)
 {
-  draw(std::make_unique<FillScreenDrawable>(color));
+  emplace<FillScreenDrawable>(color);
 }
 
 void
 DrawingContext::fill_pattern(TexturePtr pattern, const geom::foffset& offset)
 {
-  draw(std::make_unique<FillScreenPatternDrawable>(pattern, offset));
+  emplace<FillScreenPatternDrawable>(pattern, offset);
 }
 
 void
@@ -185,6 +346,18 @@ DrawingContext::get_clip_rect()
                      geom::fsize(800, 600));
 }
 
+void
+DrawingContext::stroke(bool closed, const surf::Color& color, float z_pos)
+{
+  m_stroker.stroke(m_stroke_points, closed, outline_style);
+
+  auto& array = emplace<VertexArrayDrawable>(geom::fpoint(0, 0), z_pos, modelview_stack.back(), &m_arena);
+  array.set_mode(GL_TRIANGLES);
+  array.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  m_stroker.append(array, RGBA8::from_color(color));
+  m_stroker.clear();
+}
+
 void
 DrawingContext::draw_line(const geom::fline& line, const surf::Color& color, float z_pos)
 {
@@ -194,110 +367,148 @@ DrawingContext::draw_line(const geom::fline& line, const surf::Color& color, flo
 void
 DrawingContext::draw_line(geom::fpoint const& pos1, geom::fpoint const& pos2, const surf::Color& color, float z_pos)
 {
-  auto array = std::make_unique<VertexArrayDrawable>(geom::fpoint(0, 0), z_pos, modelview_stack.back());
+  m_stroke_points.assign({ pos1.as_vec(), pos2.as_vec() });
+  stroke(false, color, z_pos);
+}
 
-  array->set_mode(GL_LINES);
-  array->set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+void
+DrawingContext::fill_rects(std::span<RectColor const> rects, float z_pos)
+{
+  if (rects.empty()) {
+    return;
+  }
 
-  array->color(color);
-  array->vertex(pos1.x(), pos1.y());
+  auto& array = emplace<VertexArrayDrawable>(geom::fpoint(0, 0), z_pos, modelview_stack.back(), &m_arena);
+  array.set_mode(GL_TRIANGLES);
+  array.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  array.add_rects(rects);
+}
+
+void
+DrawingContext::draw_lines(std::span<LineColor const> lines, float z_pos)
+{
+  if (lines.empty()) {
+    return;
+  }
 
-  array->color(color);
-  array->vertex(pos2.x(), pos2.y());
+  auto& array = emplace<VertexArrayDrawable>(geom::fpoint(0, 0), z_pos, modelview_stack.back(), &m_arena);
+  array.set_mode(GL_TRIANGLES);
+  array.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  draw(std::move(array));
+  for (LineColor const& line : lines) {
+    glm::vec2 const points[] = { line.line.p1.as_vec(), line.line.p2.as_vec() };
+    m_stroker.stroke(points, false, outline_style);
+    m_stroker.append(array, RGBA8::from_color(line.color));
+    m_stroker.clear();
+  }
 }
 
 void
-DrawingContext::draw_quad(const geom::fquad& quad, const surf::Color& color, float z_pos)
+DrawingContext::draw_surfaces(SurfacePtr const& surface, std::span<SurfaceDrawingParameters const> params,
+                              float z_pos)
 {
-  auto array = std::make_unique<VertexArrayDrawable>(geom::fpoint(0, 0), z_pos, modelview_stack.back());
-
-  array->set_mode(GL_LINE_LOOP);
-  array->set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  if (params.empty()) {
+    return;
+  }
 
-  array->color(color);
-  array->vertex(quad.p1.x(), quad.p1.y());
+  auto& array = emplace<VertexArrayDrawable>(geom::fpoint(0, 0), z_pos, modelview_stack.back(), &m_arena);
+  array.set_mode(GL_TRIANGLES);
+  array.set_texture(surface->get_texture());
+  array.set_blend_func(params.front().blendfunc_src, params.front().blendfunc_dst);
+  array.set_depth_test(params.front().depth_test);
 
-  array->color(color);
-  array->vertex(quad.p2.x(), quad.p2.y());
+  array.reserve(static_cast<int>(params.size()) * 4, true);
+  for (SurfaceDrawingParameters const& p : params) {
+    surface->append(array, p);
+  }
+}
 
-  array->color(color);
-  array->vertex(quad.p3.x(), quad.p3.y());
+void
+DrawingContext::draw_sprites(SurfacePtr const& surface, std::span<SurfaceDrawingParameters const> params,
+                             float z_pos)
+{
+  if (params.empty()) {
+    return;
+  }
 
-  array->color(color);
-  array->vertex(quad.p4.x(), quad.p4.y());
+  emplace<SpriteDrawable>(surface, params, z_pos, modelview_stack.back(), &m_arena);
+}
 
-  draw(std::move(array));
+void
+DrawingContext::draw_quad(const geom::fquad& quad, const surf::Color& color, float z_pos)
+{
+  m_stroke_points.assign({ quad.p1.as_vec(), quad.p2.as_vec(), quad.p3.as_vec(), quad.p4.as_vec() });
+  stroke(true, color, z_pos);
 }
 
 void
 DrawingContext::fill_quad(const geom::fquad& quad, const surf::Color& color, float z_pos)
 {
-  auto array = std::make_unique<VertexArrayDrawable>(geom::fpoint(0, 0), z_pos, modelview_stack.back());
+  auto& array = emplace<VertexArrayDrawable>(geom::fpoint(0, 0), z_pos, modelview_stack.back(), &m_arena);
 
-  array->set_mode(GL_TRIANGLE_FAN);
-  array->set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  array.set_mode(GL_TRIANGLES);
+  array.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  array->color(color);
-  array->vertex(quad.p1.x(), quad.p1.y());
+  array.begin(GL_TRIANGLE_FAN);
+  array.color(color);
+  array.vertex(quad.p1.x(), quad.p1.y());
 
-  array->color(color);
-  array->vertex(quad.p2.x(), quad.p2.y());
+  array.color(color);
+  array.vertex(quad.p2.x(), quad.p2.y());
 
-  array->color(color);
-  array->vertex(quad.p3.x(), quad.p3.y());
+  array.color(color);
+  array.vertex(quad.p3.x(), quad.p3.y());
 
-  array->color(color);
-  array->vertex(quad.p4.x(), quad.p4.y());
+  array.color(color);
+  array.vertex(quad.p4.x(), quad.p4.y());
 
-  draw(std::move(array));
+  array.end();
 }
 
 void
-DrawingContext::draw_rect(const geom::frect& rect, const surf::Color& color, float z_pos)
+DrawingContext::draw_circle(const geom::fpoint& pos, float radius, const surf::Color& color, float stroke, float z_pos)
 {
-  auto array = std::make_unique<VertexArrayDrawable>(geom::fpoint(0, 0), z_pos, modelview_stack.back());
-
-  array->set_mode(GL_LINE_LOOP);
-  array->set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-  array->color(color);
-  array->vertex(rect.left(), rect.top());
-
-  array->color(color);
-  array->vertex(rect.right(), rect.top());
-
-  array->color(color);
-  array->vertex(rect.right(), rect.bottom());
+  emplace<ShapeDrawable>(Shape::circle(pos, radius, color, stroke), z_pos, modelview_stack.back());
+}
 
-  array->color(color);
-  array->vertex(rect.left(), rect.bottom());
+void
+DrawingContext::fill_circle(const geom::fpoint& pos, float radius, const surf::Color& color, float z_pos)
+{
+  emplace<ShapeDrawable>(Shape::circle(pos, radius, color), z_pos, modelview_stack.back());
+}
 
-  draw(std::move(array));
+void
+DrawingContext::draw_rect(const geom::frect& rect, const surf::Color& color, float z_pos)
+{
+  m_stroke_points.assign({ glm::vec2(rect.left(), rect.top()),
+                           glm::vec2(rect.right(), rect.top()),
+                           glm::vec2(rect.right(), rect.bottom()),
+                           glm::vec2(rect.left(), rect.bottom()) });
+  stroke(true, color, z_pos);
 }
 
 void
 DrawingContext::fill_rect(const geom::frect& rect, const surf::Color& color, float z_pos)
 {
-  auto array = std::make_unique<VertexArrayDrawable>(geom::fpoint(0, 0), z_pos, modelview_stack.back());
+  auto& array = emplace<VertexArrayDrawable>(geom::fpoint(0, 0), z_pos, modelview_stack.back(), &m_arena);
 
-  array->set_mode(GL_TRIANGLE_FAN);
-  array->set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  array.set_mode(GL_TRIANGLES);
+  array.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  array->color(color);
-  array->vertex(rect.left(), rect.top());
+  array.begin(GL_TRIANGLE_FAN);
+  array.color(color);
+  array.vertex(rect.left(), rect.top());
 
-  array->color(color);
-  array->vertex(rect.right(), rect.top());
+  array.color(color);
+  array.vertex(rect.right(), rect.top());
 
-  array->color(color);
-  array->vertex(rect.right(), rect.bottom());
+  array.color(color);
+  array.vertex(rect.right(), rect.bottom());
 
-  array->color(color);
-  array->vertex(rect.left(), rect.bottom());
+  array.color(color);
+  array.vertex(rect.left(), rect.bottom());
 
-  draw(std::move(array));
+  array.end();
 }
 
 } // namespace wstdisplay
@@ -0,0 +1,96 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace wstdisplay {
+
+FrameArena::FrameArena(size_t chunk_size) :
+  m_chunk_size(chunk_size),
+  m_chunks(),
+  m_current(0),
+  m_offset(0),
+  m_bytes_used(0)
+{
+}
+
+FrameArena::~FrameArena()
+{
+}
+
+void
+FrameArena::reset()
+{
+  m_current = 0;
+  m_offset = 0;
+  m_bytes_used = 0;
+}
+
+size_t
+FrameArena::get_bytes_reserved() const
+{
+  size_t total = 0;
+  for (Chunk const& chunk : m_chunks) {
+    total += chunk.size;
+  }
+  return total;
+}
+
+void*
+FrameArena::do_allocate(size_t bytes, size_t alignment)
+{
+  while (true)
+  {
+    if (m_current == m_chunks.size()) {
+      size_t const size = std::max(m_chunk_size, bytes + alignment);
+      m_chunks.push_back(Chunk{std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+    }
+
+    Chunk& chunk = m_chunks[m_current];
+    uintptr_t const base = reinterpret_cast<uintptr_t>(chunk.data.get());
+    uintptr_t const aligned = (base + m_offset + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    size_t const offset = aligned - base;
+
+    if (offset + bytes <= chunk.size) {
+      m_offset = offset + bytes;
+      m_bytes_used += bytes;
+      return chunk.data.get() + offset;
+    }
+
+    m_current += 1;
+    m_offset = 0;
+  }
+}
+
+void
+FrameArena::do_deallocate(void* /*p*/, size_t /*bytes*/, size_t /*alignment*/)
+{
+  // memory is released in bulk by reset()
+}
+
+bool
+FrameArena::do_is_equal(std::pmr::memory_resource const& other) const noexcept
+{
+  return this == &other;
+}
+
+} // namespace wstdisplay
+
+/* EOF */
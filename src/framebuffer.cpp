@@ -105,6 +105,7 @@ Framebuffer::create_with_texture_internal(GLenum target, geom::isize const& size
 {
   assert(!size.is_empty());
 
+  GL_DEBUG_SCOPE("Framebuffer::create_with_texture");
   assert_gl();
 
   m_size = size;
@@ -132,6 +133,7 @@ Framebuffer::create_with_texture_internal(GLenum target, geom::isize const& size
 void
 Framebuffer::create_internal(GLenum format, geom::isize const& size, int multisample)
 {
+  GL_DEBUG_SCOPE("Framebuffer::create");
   assert_gl();
 
   m_size = size;
@@ -0,0 +1,115 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "fullscreen_triangle.hpp"
+
+#include "assert_gl.hpp"
+#include "graphics_context.hpp"
+
+namespace wstdisplay {
+
+namespace {
+
+const char fullscreen_vert_source[] = R"(#version 330 core
+
+out vec2 texcoord_v;
+
+uniform vec4 uv_rect;
+
+void main()
+{
+  vec2 ndc = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+
+  // (0, 0) at the top left of the screen, like the default projection
+  vec2 corner = vec2(ndc.x, -ndc.y) * 0.5 + 0.5;
+
+  texcoord_v = mix(uv_rect.xy, uv_rect.zw, corner);
+  gl_Position = vec4(ndc, 0.0, 1.0);
+}
+)";
+
+const char fullscreen_frag_source[] = R"(#version 330 core
+
+in vec2 texcoord_v;
+
+layout(location = 0) out vec4 fragRGBAf;
+
+uniform sampler2D diffuse_texture;
+
+void main()
+{
+  fragRGBAf = texture(diffuse_texture, texcoord_v);
+}
+)";
+
+} // namespace
+
+FullscreenTriangle::FullscreenTriangle() :
+  m_program(),
+  m_vao()
+{
+  assert_gl();
+
+  m_program = ShaderProgram::from_string(fullscreen_vert_source, fullscreen_frag_source);
+
+  // core profile needs a bound vertex array object even without attributes
+  glGenVertexArrays(1, &m_vao);
+
+  assert_gl();
+}
+
+FullscreenTriangle::~FullscreenTriangle()
+{
+  glDeleteVertexArrays(1, &m_vao);
+}
+
+void
+FullscreenTriangle::draw(GraphicsContext& gc, TexturePtr const& texture,
+                         glm::vec2 const& uv1, glm::vec2 const& uv2,
+                         GLenum blend_sfactor, GLenum blend_dfactor)
+{
+  GL_DEBUG_SCOPE("FullscreenTriangle::draw");
+
+  gc.flush();
+
+  GLStateTracker& state = gc.get_state();
+  state.use_program(m_program);
+  state.disable(GL_DEPTH_TEST);
+  state.enable(GL_BLEND);
+  state.blend_func(blend_sfactor, blend_dfactor);
+  state.bind_texture(0, texture);
+
+  static constexpr ShaderName uv_rect_name("uv_rect");
+  static constexpr ShaderName diffuse_texture_name("diffuse_texture");
+
+  glUniform4f(m_program->get_uniform_location(uv_rect_name), uv1.x, uv1.y, uv2.x, uv2.y);
+  glUniform1i(m_program->get_uniform_location(diffuse_texture_name), 0);
+
+  draw(gc);
+}
+
+void
+FullscreenTriangle::draw(GraphicsContext& gc)
+{
+  gc.get_state().bind_vertex_array(m_vao);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+
+  assert_gl();
+}
+
+} // namespace wstdisplay
+
+/* EOF */
@@ -0,0 +1,92 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "geometry_builder.hpp"
+
+#include <assert.h>
+
+namespace wstdisplay {
+
+GLenum
+list_mode(GLenum mode)
+{
+  switch (mode)
+  {
+    case GL_TRIANGLES:
+    case GL_TRIANGLE_FAN:
+    case GL_TRIANGLE_STRIP:
+      return GL_TRIANGLES;
+
+    case GL_LINES:
+    case GL_LINE_LOOP:
+    case GL_LINE_STRIP:
+      return GL_LINES;
+
+    case GL_POINTS:
+      return GL_POINTS;
+
+    default:
+      assert(false && "unsupported primitive mode");
+      return mode;
+  }
+}
+
+void
+append_list_indices(GLenum mode, uint32_t first, uint32_t count,
+                    std::pmr::vector<uint32_t>& indices)
+{
+  switch (mode)
+  {
+    case GL_TRIANGLE_FAN:
+      for (uint32_t i = 1; i + 1 < count; ++i) {
+        indices.insert(indices.end(), {first, first + i, first + i + 1});
+      }
+      break;
+
+    case GL_TRIANGLE_STRIP:
+      for (uint32_t i = 0; i + 2 < count; ++i) {
+        // keep the winding of every second triangle
+        if (i % 2 == 0) {
+          indices.insert(indices.end(), {first + i, first + i + 1, first + i + 2});
+        } else {
+          indices.insert(indices.end(), {first + i + 1, first + i, first + i + 2});
+        }
+      }
+      break;
+
+    case GL_LINE_STRIP:
+    case GL_LINE_LOOP:
+      for (uint32_t i = 0; i + 1 < count; ++i) {
+        indices.insert(indices.end(), {first + i, first + i + 1});
+      }
+
+      if (mode == GL_LINE_LOOP && count > 2) {
+        indices.insert(indices.end(), {first + count - 1, first});
+      }
+      break;
+
+    default:
+      for (uint32_t i = 0; i < count; ++i) {
+        indices.push_back(first + i);
+      }
+      break;
+  }
+}
+
+} // namespace wstdisplay
+
+/* EOF */
@@ -0,0 +1,144 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gl_state_tracker.hpp"
+
+#include <assert.h>
+
+#include "assert_gl.hpp"
+
+namespace wstdisplay {
+
+GLStateTracker::GLStateTracker() :
+  m_program(),
+  m_blend(),
+  m_depth_test(),
+  m_scissor_test(),
+  m_stencil_test(),
+  m_blend_sfactor(),
+  m_blend_dfactor(),
+  m_textures(),
+  m_vertex_array(),
+  m_stats()
+{
+}
+
+bool
+GLStateTracker::count(bool changed)
+{
+  if (changed) {
+    m_stats.applied += 1;
+  } else {
+    m_stats.skipped += 1;
+  }
+  return changed;
+}
+
+std::optional<bool>*
+GLStateTracker::get_cap(GLenum cap)
+{
+  switch (cap)
+  {
+    case GL_BLEND:        return &m_blend;
+    case GL_DEPTH_TEST:   return &m_depth_test;
+    case GL_SCISSOR_TEST: return &m_scissor_test;
+    case GL_STENCIL_TEST: return &m_stencil_test;
+    default:              return nullptr;
+  }
+}
+
+void
+GLStateTracker::use_program(ShaderProgramPtr const& program)
+{
+  if (count(m_program != program)) {
+    glUseProgram(program ? program->get_handle() : 0);
+    m_program = program;
+  }
+}
+
+void
+GLStateTracker::set_enabled(GLenum cap, bool enabled)
+{
+  std::optional<bool>* const state = get_cap(cap);
+
+  if (count(state == nullptr || *state != enabled)) {
+    if (enabled) {
+      glEnable(cap);
+    } else {
+      glDisable(cap);
+    }
+
+    if (state != nullptr) {
+      *state = enabled;
+    }
+  }
+}
+
+void
+GLStateTracker::blend_func(GLenum sfactor, GLenum dfactor)
+{
+  if (count(m_blend_sfactor != sfactor || m_blend_dfactor != dfactor)) {
+    glBlendFunc(sfactor, dfactor);
+    m_blend_sfactor = sfactor;
+    m_blend_dfactor = dfactor;
+  }
+}
+
+void
+GLStateTracker::bind_texture(int unit, TexturePtr const& texture)
+{
+  assert(unit >= 0 && unit < MAX_TEXTURE_UNITS);
+
+  if (count(m_textures[unit] != texture)) {
+    glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(unit));
+    glBindTexture(GL_TEXTURE_2D, texture ? texture->get_handle() : 0);
+    m_textures[unit] = texture;
+  }
+}
+
+void
+GLStateTracker::bind_vertex_array(GLuint vao)
+{
+  if (count(m_vertex_array != vao)) {
+    glBindVertexArray(vao);
+    m_vertex_array = vao;
+  }
+}
+
+void
+GLStateTracker::invalidate()
+{
+  m_program.reset();
+
+  m_blend.reset();
+  m_depth_test.reset();
+  m_scissor_test.reset();
+  m_stencil_test.reset();
+
+  m_blend_sfactor.reset();
+  m_blend_dfactor.reset();
+
+  for (auto& texture : m_textures) {
+    texture.reset();
+  }
+
+  m_vertex_array.reset();
+}
+
+} // namespace wstdisplay
+
+/* EOF */
@@ -16,112 +16,362 @@
 
 #include "gl_vertex_arrays.hpp"
 
-#include <iostream>
+#include <assert.h>
+#include <algorithm>
 
 #include "assert_gl.hpp"
-#include "graphics_context.hpp"
+#include "gl_state_tracker.hpp"
 
 namespace wstdisplay {
 
-GLVertexArrays::GLVertexArrays(GraphicsContext& gc) :
-  m_gc(gc),
+namespace {
+
+uint8_t to_byte(float v)
+{
+  return static_cast<uint8_t>(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+template<typename Vertex>
+void setup_attribs(GLenum color_type, GLboolean color_normalized, size_t color_offset)
+{
+  GLsizei const stride = sizeof(Vertex);
+
+  glVertexAttribPointer(static_cast<GLuint>(VertexAttrib::POSITION), 3, GL_FLOAT, GL_FALSE, stride,
+                        reinterpret_cast<void const*>(offsetof(Vertex, x)));
+  glEnableVertexAttribArray(static_cast<GLuint>(VertexAttrib::POSITION));
+
+  glVertexAttribPointer(static_cast<GLuint>(VertexAttrib::TEXCOORD), 2, GL_FLOAT, GL_FALSE, stride,
+                        reinterpret_cast<void const*>(offsetof(Vertex, u)));
+  glEnableVertexAttribArray(static_cast<GLuint>(VertexAttrib::TEXCOORD));
+
+  glVertexAttribPointer(static_cast<GLuint>(VertexAttrib::DIFFUSE), 4, color_type, color_normalized, stride,
+                        reinterpret_cast<void const*>(color_offset));
+  glEnableVertexAttribArray(static_cast<GLuint>(VertexAttrib::DIFFUSE));
+}
+
+template<typename Vertex>
+void copy_position_texcoord(Vertex& vertex, size_t i,
+                            std::span<float const> positions,
+                            std::span<float const> texcoords)
+{
+  vertex.x = positions[3 * i + 0];
+  vertex.y = positions[3 * i + 1];
+  vertex.z = positions[3 * i + 2];
+
+  if (texcoords.empty()) {
+    vertex.u = 0.0f;
+    vertex.v = 0.0f;
+  } else {
+    vertex.u = texcoords[2 * i + 0];
+    vertex.v = texcoords[2 * i + 1];
+  }
+}
+
+} // namespace
+
+RGBA8
+RGBA8::from_color(surf::Color const& color)
+{
+  return {to_byte(color.r), to_byte(color.g), to_byte(color.b), to_byte(color.a)};
+}
+
+GLVertexArrays::GLVertexArrays(GLStateTracker& state, size_t capacity, GLenum usage) :
   m_vao(),
-  m_positions_buffer(),
-  m_texcoords_buffer(),
-  m_color_buffer()
+  m_hdr_vao(),
+  m_diffuse_enabled(true),
+  m_hdr_diffuse_enabled(true),
+  m_buffer(),
+  m_usage(usage),
+  m_capacity(capacity),
+  m_offset(0),
+  m_index_buffer(),
+  m_index_capacity(capacity / 4),
+  m_index_offset(0),
+  m_stats()
 {
   assert_gl();
 
   glGenVertexArrays(1, &m_vao);
-  glGenBuffers(1, &m_positions_buffer);
-  glGenBuffers(1, &m_texcoords_buffer);
-  glGenBuffers(1, &m_color_buffer);
+  glGenVertexArrays(1, &m_hdr_vao);
+  glGenBuffers(1, &m_buffer);
+  glGenBuffers(1, &m_index_buffer);
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_capacity), nullptr, m_usage);
+
+  // the element buffer binding is part of the vertex array state
+  state.bind_vertex_array(m_vao);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_index_capacity), nullptr, m_usage);
+  setup_attribs<StreamVertex>(GL_UNSIGNED_BYTE, GL_TRUE, offsetof(StreamVertex, color));
+
+  state.bind_vertex_array(m_hdr_vao);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer);
+  setup_attribs<HDRStreamVertex>(GL_FLOAT, GL_FALSE, offsetof(HDRStreamVertex, r));
 
   assert_gl();
 }
 
 GLVertexArrays::~GLVertexArrays()
 {
-  glDeleteBuffers(1, &m_positions_buffer);
-  glDeleteBuffers(1, &m_texcoords_buffer);
-  glDeleteBuffers(1, &m_color_buffer);
+  glDeleteBuffers(1, &m_index_buffer);
+  glDeleteBuffers(1, &m_buffer);
+  glDeleteVertexArrays(1, &m_hdr_vao);
   glDeleteVertexArrays(1, &m_vao);
 }
 
 void
-GLVertexArrays::bind()
+GLVertexArrays::orphan()
 {
-  assert_gl();
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_capacity), nullptr, m_usage);
+  m_offset = 0;
+  m_stats.orphans += 1;
+}
+
+void
+GLVertexArrays::orphan_indices()
+{
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_index_capacity), nullptr, m_usage);
+  m_index_offset = 0;
+  m_stats.orphans += 1;
+}
 
-  glBindVertexArray(m_vao);
+void
+GLVertexArrays::set_index_capacity(size_t capacity)
+{
+  m_index_capacity = capacity;
+  orphan_indices();
+}
 
-  assert_gl();
+void
+GLVertexArrays::set_capacity(size_t capacity)
+{
+  m_capacity = capacity;
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+  orphan();
 }
 
 void
-GLVertexArrays::set_positions(std::span<float const> data)
+GLVertexArrays::set_diffuse_array(bool& enabled, bool enable)
 {
-  assert_gl();
+  GLuint const index = static_cast<GLuint>(VertexAttrib::DIFFUSE);
 
-  assert(data.size() % 3 == 0);
+  if (enable != enabled) {
+    if (enable) {
+      glEnableVertexAttribArray(index);
+    } else {
+      glDisableVertexAttribArray(index);
+    }
+    enabled = enable;
+  }
 
-  glBindBuffer(GL_ARRAY_BUFFER, m_positions_buffer);
-  glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), data.data(), GL_DYNAMIC_DRAW);
+  if (!enable) {
+    // the current attribute value is undefined after drawing from an
+    // array, so it has to be set each time
+    glVertexAttrib4f(index, 1.0f, 1.0f, 1.0f, 1.0f);
+  }
+}
 
-  assert_gl();
+void*
+GLVertexArrays::map_indices(size_t bytes, size_t alignment)
+{
+  m_index_offset = (m_index_offset + alignment - 1) / alignment * alignment;
 
-  int loc = m_gc.get_default_shader()->get_attrib_location("position");
-  if (loc == -1) {
-    std::cout << "failed to set position\n";
-  } else {
-    assert_gl();
-    glVertexAttribPointer(loc, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-    assert_gl();
-    glEnableVertexAttribArray(loc);
-    assert_gl();
+  if (bytes > m_index_capacity) {
+    m_index_capacity = std::max(bytes, m_index_capacity * 2);
+    orphan_indices();
+  } else if (m_index_offset + bytes > m_index_capacity) {
+    orphan_indices();
   }
 
+  void* const ptr = glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER,
+                                     static_cast<GLintptr>(m_index_offset), static_cast<GLsizeiptr>(bytes),
+                                     GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
   assert_gl();
+
+  return ptr;
 }
 
-void
-GLVertexArrays::set_texcoords(std::span<float const> data)
+GLintptr
+GLVertexArrays::unmap_indices(size_t bytes)
 {
+  glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
   assert_gl();
 
-  glBindBuffer(GL_ARRAY_BUFFER, m_texcoords_buffer);
-  glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), data.data(), GL_DYNAMIC_DRAW);
+  GLintptr const offset = static_cast<GLintptr>(m_index_offset);
+
+  m_index_offset += bytes;
+  m_stats.bytes_streamed += bytes;
+  m_stats.uploads += 1;
+
+  return offset;
+}
+
+GLintptr
+GLVertexArrays::upload_indices(std::span<uint32_t const> indices, GLenum type)
+{
+  assert(type == GL_UNSIGNED_SHORT || type == GL_UNSIGNED_INT);
+
+  if (indices.empty()) {
+    return 0;
+  }
+
+  size_t const index_size = (type == GL_UNSIGNED_SHORT) ? sizeof(uint16_t) : sizeof(uint32_t);
+  size_t const bytes = indices.size() * index_size;
+
+  void* const ptr = map_indices(bytes, index_size);
 
-  int loc = m_gc.get_default_shader()->get_attrib_location("texcoord");
-  if (loc != -1) {
-    assert_gl();
-    glVertexAttribPointer(loc, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
-    assert_gl();
-    glEnableVertexAttribArray(loc);
+  if (type == GL_UNSIGNED_SHORT) {
+    auto* const out = static_cast<uint16_t*>(ptr);
+    for (size_t i = 0; i < indices.size(); ++i) {
+      assert(indices[i] <= 0xffff);
+      out[i] = static_cast<uint16_t>(indices[i]);
+    }
   } else {
-    std::cout << "failed to set texcoord\n";
+    std::copy(indices.begin(), indices.end(), static_cast<uint32_t*>(ptr));
   }
 
-  assert_gl();
+  return unmap_indices(bytes);
+}
+
+GLintptr
+GLVertexArrays::upload_indices(std::span<uint16_t const> indices)
+{
+  if (indices.empty()) {
+    return 0;
+  }
+
+  size_t const bytes = indices.size() * sizeof(uint16_t);
+
+  void* const ptr = map_indices(bytes, sizeof(uint16_t));
+  std::copy(indices.begin(), indices.end(), static_cast<uint16_t*>(ptr));
+
+  return unmap_indices(bytes);
 }
 
 void
-GLVertexArrays::set_colors(std::span<float const> data)
+GLVertexArrays::apply_constant_color(bool hdr) const
 {
+  if (!(hdr ? m_hdr_diffuse_enabled : m_diffuse_enabled)) {
+    glVertexAttrib4f(static_cast<GLuint>(VertexAttrib::DIFFUSE), 1.0f, 1.0f, 1.0f, 1.0f);
+  }
+}
+
+void*
+GLVertexArrays::map(size_t count, size_t stride)
+{
+  size_t const bytes = count * stride;
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+
+  // both vertex formats share the buffer, the first vertex has to
+  // land on a multiple of the stride
+  m_offset = (m_offset + stride - 1) / stride * stride;
+
+  if (bytes > m_capacity) {
+    m_capacity = std::max(bytes, m_capacity * 2);
+    orphan();
+  } else if (m_offset + bytes > m_capacity) {
+    orphan();
+  }
+
+  void* const ptr = glMapBufferRange(GL_ARRAY_BUFFER, static_cast<GLintptr>(m_offset), static_cast<GLsizeiptr>(bytes),
+                                     GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
   assert_gl();
 
-  glBindBuffer(GL_ARRAY_BUFFER, m_color_buffer);
-  glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), data.data(), GL_DYNAMIC_DRAW);
+  return ptr;
+}
 
-  int loc = m_gc.get_default_shader()->get_attrib_location("diffuse");
-  if (loc != -1) {
-    glVertexAttribPointer(loc, 4, GL_FLOAT, GL_FALSE, 0, nullptr);
-    glEnableVertexAttribArray(loc);
-  } else {
-    std::cout << "failed to set colors\n";
+GLint
+GLVertexArrays::unmap(size_t count, size_t stride)
+{
+  size_t const bytes = count * stride;
+
+  glUnmapBuffer(GL_ARRAY_BUFFER);
+  assert_gl();
+
+  GLint const first = static_cast<GLint>(m_offset / stride);
+
+  m_offset += bytes;
+  m_stats.bytes_streamed += bytes;
+  m_stats.uploads += 1;
+
+  return first;
+}
+
+GLint
+GLVertexArrays::upload(std::span<float const> positions,
+                       std::span<float const> texcoords,
+                       std::span<RGBA8 const> colors)
+{
+  assert_gl();
+
+  assert(positions.size() % 3 == 0);
+
+  size_t const count = positions.size() / 3;
+
+  assert(texcoords.empty() || texcoords.size() == count * 2);
+  assert(colors.empty() || colors.size() == count);
+
+  if (count == 0) {
+    return 0;
   }
 
+  set_diffuse_array(m_diffuse_enabled, !colors.empty());
+
+  auto* const vertices = static_cast<StreamVertex*>(map(count, sizeof(StreamVertex)));
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    StreamVertex& vertex = vertices[i];
+
+    copy_position_texcoord(vertex, i, positions, texcoords);
+    vertex.color = colors.empty() ? RGBA8::white() : colors[i];
+  }
+
+  return unmap(count, sizeof(StreamVertex));
+}
+
+GLint
+GLVertexArrays::upload_hdr(std::span<float const> positions,
+                           std::span<float const> texcoords,
+                           std::span<float const> colors)
+{
   assert_gl();
+
+  assert(positions.size() % 3 == 0);
+
+  size_t const count = positions.size() / 3;
+
+  assert(texcoords.empty() || texcoords.size() == count * 2);
+  assert(colors.empty() || colors.size() == count * 4);
+
+  if (count == 0) {
+    return 0;
+  }
+
+  set_diffuse_array(m_hdr_diffuse_enabled, !colors.empty());
+
+  auto* const vertices = static_cast<HDRStreamVertex*>(map(count, sizeof(HDRStreamVertex)));
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    HDRStreamVertex& vertex = vertices[i];
+
+    copy_position_texcoord(vertex, i, positions, texcoords);
+
+    if (colors.empty()) {
+      vertex.r = vertex.g = vertex.b = vertex.a = 1.0f;
+    } else {
+      vertex.r = colors[4 * i + 0];
+      vertex.g = colors[4 * i + 1];
+      vertex.b = colors[4 * i + 2];
+      vertex.a = colors[4 * i + 3];
+    }
+  }
+
+  return unmap(count, sizeof(HDRStreamVertex));
 }
 
 } // namespace wstdisplay
@@ -23,6 +23,8 @@
 #include <stdexcept>
 #include <string.h>
 
+#include <glm/gtc/constants.hpp>
+
 #include <geom/rect.hpp>
 #include <geom/line.hpp>
 #include <geom/quad.hpp>
@@ -30,6 +32,9 @@
 #include <surf/palette.hpp>
 
 #include "assert_gl.hpp"
+#include "circle_table.hpp"
+#include "sprite_renderer.hpp"
+#include "surface_drawing_parameters.hpp"
 
 #include "scenegraph/vertex_array_drawable.hpp"
 
@@ -41,9 +46,9 @@ std::vector<FramebufferPtr> framebuffers;
 
 const char default_vert_source[] = R"(#version 330 core
 
-in vec2 texcoord;
-in vec4 diffuse;
-in vec3 position;
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec2 texcoord;
+layout(location = 2) in vec4 diffuse;
 
 out vec2 texcoord_v;
 out vec4 diffuse_v;
@@ -73,16 +78,63 @@ void main()
 }
 )";
 
+const char gradient_vert_source[] = R"(#version 330 core
+
+out float position_v;
+
+uniform mat4 inverse_projection;
+uniform float height;
+
+void main()
+{
+  // see FullscreenTriangle
+  vec2 ndc = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+
+  // map back to screen coordinates, so that the gradient lines up
+  // with the geometry version under any projection
+  position_v = (inverse_projection * vec4(ndc, 0.0, 1.0)).y / height;
+  gl_Position = vec4(ndc, 0.0, 1.0);
+}
+)";
+
+const char gradient_frag_source[] = R"(#version 330 core
+
+in float position_v;
+
+layout(location = 0) out vec4 fragRGBAf;
+
+uniform sampler2D lut;
+
+void main()
+{
+  fragRGBAf = texture(lut, vec2(position_v, 0.5));
+}
+)";
+
 } // namespace
 
 GraphicsContext::GraphicsContext() :
   m_size(640, 480),
   m_cliprects(),
   m_default_shader(),
+  m_gradient_program(),
   m_white_texture(),
   m_modelview_stack(),
   m_projection(1.0f),
-  m_vertex_arrays(*this)
+  m_state(),
+  m_vertex_arrays(m_state),
+  m_primitive(std::make_unique<VertexArrayDrawable>()),
+  m_primitive_batch(std::make_unique<VertexArrayDrawable>()),
+  m_primitive_state(),
+  m_flushing(false),
+  m_sprite_renderer(),
+  m_shape_renderer(),
+  m_grid_renderer(),
+  m_fullscreen_triangle(),
+  m_shape_backend(ShapeBackend::TESSELLATED),
+  m_stroker(),
+  m_stroke_style(),
+  m_stroke_points()
 {
   assert_gl();
 
@@ -94,7 +146,7 @@ GraphicsContext::GraphicsContext() :
   m_white_texture = Texture::create(SoftwareSurface::create(surf::PixelFormat::RGBA8, geom::isize(1, 1),
                                                             surf::palette::white));
 
-  glUseProgram(m_default_shader->get_handle());
+  m_state.use_program(m_default_shader);
 
   assert_gl();
 }
@@ -103,9 +155,95 @@ GraphicsContext::~GraphicsContext()
 {
 }
 
+void
+GraphicsContext::flush()
+{
+  flush_primitives();
+  flush_shapes();
+}
+
+void
+GraphicsContext::flush_primitives()
+{
+  if (m_flushing || !m_primitive_state) {
+    return;
+  }
+
+  m_flushing = true;
+  m_primitive_batch->render(*this, ~0u);
+  m_primitive_state.reset();
+  m_flushing = false;
+}
+
+void
+GraphicsContext::flush_shapes()
+{
+  if (m_flushing || !m_shape_renderer) {
+    return;
+  }
+
+  m_flushing = true;
+  m_shape_renderer->flush(*this);
+  m_flushing = false;
+}
+
+VertexArrayDrawable&
+GraphicsContext::begin_primitive()
+{
+  m_primitive->clear();
+  m_primitive->set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  m_primitive->set_depth_test(false);
+  return *m_primitive;
+}
+
+void
+GraphicsContext::end_primitive(VertexArrayDrawable& va)
+{
+  BatchState state;
+  if (!va.get_batch_state(state)) {
+    flush();
+    va.render(*this, ~0u);
+    return;
+  }
+
+  if (m_primitive_state != state) {
+    flush();
+
+    m_primitive_batch->clear();
+    m_primitive_batch->set_program(state.program);
+    m_primitive_batch->set_mode(state.mode);
+    if (state.texture) {
+      m_primitive_batch->set_texture(state.texture);
+    }
+    m_primitive_batch->set_blend_func(state.blend_sfactor, state.blend_dfactor);
+    m_primitive_batch->set_depth_test(state.depth_test);
+
+    m_primitive_state = state;
+  }
+
+  // keep the order with shapes queued before
+  flush_shapes();
+
+  // matrix changes flush the batch, so it is drawn with the same
+  // modelview the shape was submitted with
+  va.append_to_batch(*m_primitive_batch);
+}
+
+void
+GraphicsContext::end_stroke(surf::Color const& color)
+{
+  VertexArrayDrawable& va = begin_primitive();
+  va.set_mode(GL_TRIANGLES);
+  m_stroker.append(va, RGBA8::from_color(color));
+  m_stroker.clear();
+  end_primitive(va);
+}
+
 void
 GraphicsContext::clear(surf::Color const& color)
 {
+  flush();
+
   glClearColor(color.r, color.g, color.b, color.a);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
@@ -134,53 +272,82 @@ GraphicsContext::draw_line_with_normal(const geom::fline& line, const surf::Colo
 void
 GraphicsContext::draw_line(const geom::fpoint& pos1, const geom::fpoint& pos2, const surf::Color& color)
 {
-  VertexArrayDrawable va;
-
-  //state.enable(GL_LINE_SMOOTH);
-  va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  va.set_mode(GL_LINES);
-
-  va.color(color);
-  va.vertex(pos1.x(), pos1.y());
+  glm::vec2 const points[] = { pos1.as_vec(), pos2.as_vec() };
+  m_stroker.stroke(points, false, m_stroke_style);
+  end_stroke(color);
+}
 
-  va.color(color);
-  va.vertex(pos2.x(), pos2.y());
+void
+GraphicsContext::fill_rects(std::span<RectColor const> rects)
+{
+  if (rects.empty()) {
+    return;
+  }
 
-  va.render(*this, ~0u);
+  VertexArrayDrawable& va = begin_primitive();
+  va.set_mode(GL_TRIANGLES);
+  va.add_rects(rects);
+  end_primitive(va);
 }
 
 void
-GraphicsContext::fill_quad(const geom::fquad& quad, const surf::Color& color)
+GraphicsContext::draw_lines(std::span<LineColor const> lines)
 {
-  VertexArrayDrawable va;
+  if (lines.empty()) {
+    return;
+  }
 
-  va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  VertexArrayDrawable& va = begin_primitive();
+  va.set_mode(GL_TRIANGLES);
+  for (LineColor const& line : lines) {
+    glm::vec2 const points[] = { line.line.p1.as_vec(), line.line.p2.as_vec() };
+    m_stroker.stroke(points, false, m_stroke_style);
+    m_stroker.append(va, RGBA8::from_color(line.color));
+    m_stroker.clear();
+  }
+  end_primitive(va);
+}
 
-  va.set_mode(GL_TRIANGLE_FAN);
+void
+GraphicsContext::draw_surfaces(SurfacePtr const& surface, std::span<SurfaceDrawingParameters const> params)
+{
+  if (params.empty()) {
+    return;
+  }
 
-  va.color(color);
-  va.vertex(quad.p1.x(), quad.p1.y());
+  VertexArrayDrawable& va = begin_primitive();
+  va.set_mode(GL_TRIANGLES);
+  va.set_texture(surface->get_texture());
+  va.set_blend_func(params.front().blendfunc_src, params.front().blendfunc_dst);
+  va.set_depth_test(params.front().depth_test);
 
-  va.color(color);
-  va.vertex(quad.p2.x(), quad.p2.y());
+  va.reserve(static_cast<int>(params.size()) * 4, true);
+  for (SurfaceDrawingParameters const& p : params) {
+    surface->append(va, p);
+  }
 
-  va.color(color);
-  va.vertex(quad.p3.x(), quad.p3.y());
+  end_primitive(va);
+}
 
-  va.color(color);
-  va.vertex(quad.p4.x(), quad.p4.y());
+void
+GraphicsContext::draw_sprites(SurfacePtr const& surface, std::span<SurfaceDrawingParameters const> params)
+{
+  if (!m_sprite_renderer) {
+    m_sprite_renderer = std::make_unique<SpriteRenderer>(m_state);
+  }
 
-  va.render(*this, ~0u);
+  m_sprite_renderer->draw(*this, surface, params);
 }
 
 void
-GraphicsContext::draw_quad(const geom::fquad& quad, const surf::Color& color)
+GraphicsContext::fill_quad(const geom::fquad& quad, const surf::Color& color)
 {
-  VertexArrayDrawable va;
+  VertexArrayDrawable& va = begin_primitive();
 
   va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  va.set_mode(GL_LINE_LOOP);
+  va.set_mode(GL_TRIANGLES);
+  va.begin(GL_TRIANGLE_FAN);
 
   va.color(color);
   va.vertex(quad.p1.x(), quad.p1.y());
@@ -194,17 +361,29 @@ GraphicsContext::draw_quad(const geom::fquad& quad, const surf::Color& color)
   va.color(color);
   va.vertex(quad.p4.x(), quad.p4.y());
 
-  va.render(*this, ~0u);
+  va.end();
+  end_primitive(va);
+}
+
+void
+GraphicsContext::draw_quad(const geom::fquad& quad, const surf::Color& color)
+{
+  glm::vec2 const points[] = {
+    quad.p1.as_vec(), quad.p2.as_vec(), quad.p3.as_vec(), quad.p4.as_vec()
+  };
+  m_stroker.stroke(points, true, m_stroke_style);
+  end_stroke(color);
 }
 
 void
 GraphicsContext::fill_rect(const geom::frect& rect, const surf::Color& color)
 {
-  VertexArrayDrawable va;
+  VertexArrayDrawable& va = begin_primitive();
 
   va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  va.set_mode(GL_TRIANGLE_FAN);
+  va.set_mode(GL_TRIANGLES);
+  va.begin(GL_TRIANGLE_FAN);
 
   va.color(color);
   va.vertex(rect.left(),  rect.top());
@@ -218,36 +397,68 @@ GraphicsContext::fill_rect(const geom::frect& rect, const surf::Color& color)
   va.color(color);
   va.vertex(rect.left(),  rect.bottom());
 
-  va.render(*this, ~0u);
+  va.end();
+  end_primitive(va);
 }
 
 void
 GraphicsContext::draw_rect(const geom::frect& rect, const surf::Color& color)
 {
-  VertexArrayDrawable va;
-
-  va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-  va.set_mode(GL_LINE_LOOP);
-
-  va.color(color);
-  va.vertex(rect.left(),  rect.top());
-
-  va.color(color);
-  va.vertex(rect.right(), rect.top());
+  glm::vec2 const points[] = {
+    glm::vec2(rect.left(),  rect.top()),
+    glm::vec2(rect.right(), rect.top()),
+    glm::vec2(rect.right(), rect.bottom()),
+    glm::vec2(rect.left(),  rect.bottom())
+  };
+  m_stroker.stroke(points, true, m_stroke_style);
+  end_stroke(color);
+}
 
-  va.color(color);
-  va.vertex(rect.right(), rect.bottom());
+int
+GraphicsContext::segments_for(float radius) const
+{
+  // length of the x and y axis in pixels after projection
+  glm::mat4 const mvp = m_projection * get_modelview();
+  float const sx = glm::length(glm::vec2(mvp[0].x, mvp[0].y)) * 0.5f * static_cast<float>(m_size.width());
+  float const sy = glm::length(glm::vec2(mvp[1].x, mvp[1].y)) * 0.5f * static_cast<float>(m_size.height());
 
-  va.color(color);
-  va.vertex(rect.left(),  rect.bottom());
+  return circle_segments(radius * std::max(sx, sy));
+}
 
-  va.render(*this, ~0u);
+void
+GraphicsContext::arc_points(std::vector<glm::vec2>& points, geom::fpoint const& pos, float radius,
+                            float start, float end, int segments) const
+{
+  int const n = segments ? segments : segments_for(radius);
+  std::span<glm::vec2 const> const circle = unit_circle(n);
+
+  // table indices strictly between start and end, start is moved into
+  // [0, 2pi) so that the indices can wrap around
+  float const turns = static_cast<float>(n) / glm::two_pi<float>();
+  float const offset = floorf(start / glm::two_pi<float>()) * glm::two_pi<float>();
+  int const first = static_cast<int>(floorf((start - offset) * turns)) + 1;
+  int const last = static_cast<int>(ceilf((end - offset) * turns)) - 1;
+
+  auto add = [&](glm::vec2 const& p) {
+    points.emplace_back(p.x * radius + pos.x(), p.y * radius + pos.y());
+  };
+
+  add(glm::vec2(cosf(start), sinf(start)));
+  for (int i = first; i <= last; ++i) {
+    add(circle[static_cast<size_t>(i % n)]);
+  }
+  add(glm::vec2(cosf(end), sinf(end)));
 }
 
 void
 GraphicsContext::fill_rounded_rect(const geom::frect& rect, float radius, const surf::Color& color)
 {
+  if (m_shape_backend == ShapeBackend::SDF) {
+    Shape const shape = Shape::rounded_rect(rect, radius, color);
+    draw_shapes({&shape, 1});
+    return;
+  }
+
   // Keep radius in the limits, so that we get a circle instead of
   // just graphic junk
   radius = std::min(radius, std::min(rect.width()/2, rect.height()/2));
@@ -258,42 +469,52 @@ GraphicsContext::fill_rounded_rect(const geom::frect& rect, float radius, const
                     rect.right()   - radius,
                     rect.bottom()  - radius);
 
-  VertexArrayDrawable va;
+  std::span<glm::vec2 const> const arc = quarter_arc(segments_for(radius) / 4);
+  RGBA8 const rgba = RGBA8::from_color(color);
+
+  VertexArrayDrawable& va = begin_primitive();
 
   va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  int n = 8;
-  va.set_mode(GL_TRIANGLE_STRIP);
-  for(int i = 0; i <= n; ++i)
+  va.set_mode(GL_TRIANGLES);
+  va.begin(GL_TRIANGLE_STRIP);
+  for (glm::vec2 const& p : arc)
   {
-    float x = sinf(static_cast<float>(i) * glm::half_pi<float>() / static_cast<float>(n)) * radius;
-    float y = cosf(static_cast<float>(i) * glm::half_pi<float>() / static_cast<float>(n)) * radius;
+    float x = p.y * radius;
+    float y = p.x * radius;
 
     // v2
-    va.color(color);
+    va.color(rgba);
     va.vertex(irect.right() + x, irect.top() - y);
     // v1
-    va.color(color);
+    va.color(rgba);
     va.vertex(irect.left()  - x, irect.top() - y);
   }
-  for(int i = 0; i <= n; ++i)
+  for (glm::vec2 const& p : arc)
   {
-    float x = cosf(static_cast<float>(i) * glm::half_pi<float>() / static_cast<float>(n)) * radius;
-    float y = sinf(static_cast<float>(i) * glm::half_pi<float>() / static_cast<float>(n)) * radius;
+    float x = p.x * radius;
+    float y = p.y * radius;
 
     // v2
-    va.color(color);
+    va.color(rgba);
     va.vertex(irect.right() + x, irect.bottom() + y);
     // v1
-    va.color(color);
+    va.color(rgba);
     va.vertex(irect.left()  - x, irect.bottom() + y);
   }
-  va.render(*this, ~0u);
+  va.end();
+  end_primitive(va);
 }
 
 void
 GraphicsContext::draw_rounded_rect(const geom::frect& rect, float radius, const surf::Color& color)
 {
+  if (m_shape_backend == ShapeBackend::SDF) {
+    Shape const shape = Shape::rounded_rect(rect, radius, color, m_stroke_style.width);
+    draw_shapes({&shape, 1});
+    return;
+  }
+
   // Keep radius in the limits, so that we get a circle instead of
   // just graphic junk
   radius = std::min(radius, std::min(rect.width()/2, rect.height()/2));
@@ -304,116 +525,93 @@ GraphicsContext::draw_rounded_rect(const geom::frect& rect, float radius, const
                     rect.right()   - radius,
                     rect.bottom()  - radius);
 
-  VertexArrayDrawable va;
-
-  // state.enable(GL_LINE_SMOOTH);
-  va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  std::span<glm::vec2 const> const arc = quarter_arc(segments_for(radius) / 4);
 
-  int n = 4;
-  va.set_mode(GL_LINE_STRIP);
-  for(int i = 0; i <= n; ++i)
-  {
-    float x = sinf(static_cast<float>(i) * glm::half_pi<float>() / static_cast<float>(n)) * radius;
-    float y = cosf(static_cast<float>(i) * glm::half_pi<float>() / static_cast<float>(n)) * radius;
-
-    va.color(color);
-    va.vertex(irect.left()  - x, irect.top() - y);
+  std::vector<glm::vec2>& points = m_stroke_points;
+  points.clear();
+  for (glm::vec2 const& p : arc) {
+    points.emplace_back(irect.left()  - p.y * radius, irect.top() - p.x * radius);
   }
-  for(int i = 0; i <= n; ++i)
-  {
-    float x = cosf(static_cast<float>(i) * glm::half_pi<float>() / static_cast<float>(n)) * radius;
-    float y = sinf(static_cast<float>(i) * glm::half_pi<float>() / static_cast<float>(n)) * radius;
-
-    va.color(color);
-    va.vertex(irect.left()  - x, irect.bottom() + y);
+  for (glm::vec2 const& p : arc) {
+    points.emplace_back(irect.left()  - p.x * radius, irect.bottom() + p.y * radius);
   }
-
-  for(int i = 0; i <= n; ++i)
-  {
-    float x = sinf(static_cast<float>(i) * glm::half_pi<float>() / static_cast<float>(n)) * radius;
-    float y = cosf(static_cast<float>(i) * glm::half_pi<float>() / static_cast<float>(n)) * radius;
-
-    va.color(color);
-    va.vertex(irect.right() + x, irect.bottom() + y);
+  for (glm::vec2 const& p : arc) {
+    points.emplace_back(irect.right() + p.y * radius, irect.bottom() + p.x * radius);
   }
-
-  for(int i = 0; i <= n; ++i)
-  {
-    float x = cosf(static_cast<float>(i) * glm::half_pi<float>() / static_cast<float>(n)) * radius;
-    float y = sinf(static_cast<float>(i) * glm::half_pi<float>() / static_cast<float>(n)) * radius;
-
-    va.color(color);
-    va.vertex(irect.right() + x, irect.top() - y);
+  for (glm::vec2 const& p : arc) {
+    points.emplace_back(irect.right() + p.x * radius, irect.top() - p.y * radius);
   }
-  // go back to start
-  va.color(color);
-  va.vertex(irect.left(), irect.top() - radius);
 
-  va.render(*this, ~0u);
+  m_stroker.stroke(points, true, m_stroke_style);
+  end_stroke(color);
 }
 
 void
 GraphicsContext::draw_circle(const geom::fpoint& pos, float radius, const surf::Color& color, int segments)
 {
-  assert(segments >= 0);
-
-  VertexArrayDrawable va;
-
-  //state.enable(GL_LINE_SMOOTH);
-  va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  if (m_shape_backend == ShapeBackend::SDF) {
+    Shape const shape = Shape::circle(pos, radius, color, m_stroke_style.width);
+    draw_shapes({&shape, 1});
+    return;
+  }
 
-  float n = static_cast<float>(segments) / 4.0f;
-  va.set_mode(GL_LINE_STRIP);
+  assert(segments >= 0);
 
-  va.color(color);
-  va.vertex(radius + pos.x(), pos.y());
-  for(int i = 1; i < segments; ++i)
-  {
-    float x = cosf(static_cast<float>(i) * glm::half_pi<float>() / n) * radius;
-    float y = sinf(static_cast<float>(i) * glm::half_pi<float>() / n) * radius;
+  std::span<glm::vec2 const> const circle = unit_circle(segments ? segments : segments_for(radius));
 
-    va.color(color);
-    va.vertex(x + pos.x(), y + pos.y());
+  std::vector<glm::vec2>& points = m_stroke_points;
+  points.clear();
+  for (glm::vec2 const& p : circle) {
+    points.emplace_back(p.x * radius + pos.x(), p.y * radius + pos.y());
   }
-  va.color(color);
-  va.vertex(radius + pos.x(), pos.y());
 
-  va.render(*this, ~0u);
+  m_stroker.stroke(points, true, m_stroke_style);
+  end_stroke(color);
 }
 
 void
 GraphicsContext::fill_circle(const geom::fpoint& pos, float radius, const surf::Color& color, int segments)
 {
+  if (m_shape_backend == ShapeBackend::SDF) {
+    Shape const shape = Shape::circle(pos, radius, color);
+    draw_shapes({&shape, 1});
+    return;
+  }
+
   assert(segments >= 0);
 
-  VertexArrayDrawable va;
+  std::span<glm::vec2 const> const circle = unit_circle(segments ? segments : segments_for(radius));
+  RGBA8 const rgba = RGBA8::from_color(color);
+
+  VertexArrayDrawable& va = begin_primitive();
 
   va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  float n = static_cast<float>(segments) / 4.0f;
-  va.set_mode(GL_TRIANGLE_FAN);
+  va.set_mode(GL_TRIANGLES);
+  va.reserve(static_cast<int>(circle.size()) + 1);
+  va.begin(GL_TRIANGLE_FAN);
 
-  va.color(color);
+  va.color(rgba);
   va.vertex(pos.x(), pos.y());
 
-  va.color(color);
-  va.vertex(radius + pos.x(), pos.y());
-  for(int i = 1; i < segments; ++i) {
-    float x = cosf(static_cast<float>(i) * glm::half_pi<float>() / n) * radius;
-    float y = sinf(static_cast<float>(i) * glm::half_pi<float>() / n) * radius;
-
-    va.color(color);
-    va.vertex(x + pos.x(), y + pos.y());
+  for (glm::vec2 const& p : circle) {
+    va.color(rgba);
+    va.vertex(p.x * radius + pos.x(), p.y * radius + pos.y());
   }
-  va.color(color);
-  va.vertex(radius + pos.x(), pos.y());
 
-  va.render(*this, ~0u);
+  va.end();
+  end_primitive(va);
 }
 
 void
 GraphicsContext::draw_arc(const geom::fpoint& pos, float radius, float start, float end, const surf::Color& color, int segments)
 {
+  if (m_shape_backend == ShapeBackend::SDF && fabsf(end - start) < 360.0f) {
+    Shape const shape = Shape::arc(pos, radius, start, end, color, m_stroke_style.width);
+    draw_shapes({&shape, 1});
+    return;
+  }
+
   assert(segments >= 0);
 
   if (fabsf(end - start) >= 360.0f)
@@ -422,43 +620,28 @@ GraphicsContext::draw_arc(const geom::fpoint& pos, float radius, float start, fl
   }
   else
   {
-    float step  = glm::two_pi<float>() / static_cast<float>(segments);
-
     if (start > end)
       std::swap(start, end);
 
-    VertexArrayDrawable va;
-
-    va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    start = glm::radians(start);
-    end   = glm::radians(end);
-
-    va.set_mode(GL_LINE_STRIP);
-
-    va.color(color);
-    va.vertex(pos.x(), pos.y());
-
-    for(float angle = start; angle < end; angle += step) {
-      va.color(color);
-      va.vertex((cosf(angle) * radius) + pos.x(),
-                (sinf(angle) * radius) + pos.y());
-    }
-
-    va.color(color);
-    va.vertex((cosf(end) * radius) + pos.x(),
-              (sinf(end) * radius) + pos.y());
+    std::vector<glm::vec2>& points = m_stroke_points;
+    points.clear();
+    points.push_back(pos.as_vec());
+    arc_points(points, pos, radius, glm::radians(start), glm::radians(end), segments);
 
-    va.color(color);
-    va.vertex(pos.x(), pos.y());
-
-    va.render(*this, ~0u);
+    m_stroker.stroke(points, true, m_stroke_style);
+    end_stroke(color);
   }
 }
 
 void
 GraphicsContext::fill_arc(const geom::fpoint& pos, float radius, float start, float end, const surf::Color& color, int segments)
 {
+  if (m_shape_backend == ShapeBackend::SDF && fabsf(end - start) < 360.0f) {
+    Shape const shape = Shape::arc(pos, radius, start, end, color);
+    draw_shapes({&shape, 1});
+    return;
+  }
+
   assert(segments >= 0);
 
   if (fabsf(end - start) >= 360.0f)
@@ -467,74 +650,101 @@ GraphicsContext::fill_arc(const geom::fpoint& pos, float radius, float start, fl
   }
   else
   {
-    float step  = glm::two_pi<float>() / static_cast<float>(segments);
-
     if (start > end)
       std::swap(start, end);
 
-    VertexArrayDrawable va;
+    std::vector<glm::vec2>& points = m_stroke_points;
+    points.clear();
+    arc_points(points, pos, radius, glm::radians(start), glm::radians(end), segments);
 
-    va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    RGBA8 const rgba = RGBA8::from_color(color);
 
-    start = glm::radians(start);
-    end   = glm::radians(end);
+    VertexArrayDrawable& va = begin_primitive();
 
-    va.set_mode(GL_TRIANGLE_FAN);
+    va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    va.set_mode(GL_TRIANGLES);
+    va.reserve(static_cast<int>(points.size()) + 1);
+    va.begin(GL_TRIANGLE_FAN);
 
-    va.color(color);
+    va.color(rgba);
     va.vertex(pos.x(), pos.y());
 
-    for(float angle = start; angle < end; angle += step) {
-      va.color(color);
-      va.vertex((cosf(angle) * radius) + pos.x(),
-                (sinf(angle) * radius) + pos.y());
+    for (glm::vec2 const& p : points) {
+      va.color(rgba);
+      va.vertex(p.x, p.y);
     }
 
-    va.color(color);
-    va.vertex(cosf(end) * radius + pos.x(),
-              sinf(end) * radius + pos.y());
-
-    va.render(*this, ~0u);
+    va.end();
+    end_primitive(va);
   }
 }
 
 void
 GraphicsContext::draw_grid(const geom::fpoint& offset, const geom::fsize& size, const surf::Color& rgba)
 {
-  VertexArrayDrawable va;
+  Grid grid;
+  grid.offset = offset;
+  grid.size = size;
+  grid.color = rgba;
+  grid.line_width = m_stroke_style.width;
+  grid.major_line_width = m_stroke_style.width;
+  grid.fade_start = 0.0f;
+  grid.fade_end = 0.0f;
+  draw_grid(grid);
+}
 
-  va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+void
+GraphicsContext::draw_grid(Grid const& grid)
+{
+  if (!m_grid_renderer) {
+    m_grid_renderer = std::make_unique<GridRenderer>();
+  }
 
-  va.set_mode(GL_LINES);
-  //glsurf::Color4ub(rgba.r, rgba.g, rgba.b, rgba.a);
+  m_grid_renderer->draw(*this, grid);
+}
 
-  float start_x = fmodf(offset.x(), size.width());
-  float start_y = fmodf(offset.y(), size.height());
+ShaderProgramPtr const&
+GraphicsContext::get_gradient_program()
+{
+  if (!m_gradient_program) {
+    m_gradient_program = ShaderProgram::from_string(gradient_vert_source, gradient_frag_source);
+  }
 
-  for(float x = start_x; x < static_cast<float>(m_size.width()); x += size.width())
-  {
-    va.color(rgba);
-    va.vertex(x, 0.0f);
+  return m_gradient_program;
+}
 
-    va.color(rgba);
-    va.vertex(x, static_cast<float>(m_size.height()));
+FullscreenTriangle&
+GraphicsContext::get_fullscreen_triangle()
+{
+  if (!m_fullscreen_triangle) {
+    m_fullscreen_triangle = std::make_unique<FullscreenTriangle>();
   }
 
-  for(float y = start_y; y < static_cast<float>(m_size.height()); y += size.height())
-  {
-    va.color(rgba);
-    va.vertex(0.0f, y);
+  return *m_fullscreen_triangle;
+}
 
-    va.color(rgba);
-    va.vertex(static_cast<float>(m_size.width()), y);
+void
+GraphicsContext::draw_shapes(std::span<Shape const> shapes)
+{
+  if (shapes.empty()) {
+    return;
+  }
+
+  flush_primitives();
+
+  if (!m_shape_renderer) {
+    m_shape_renderer = std::make_unique<ShapeRenderer>(m_state);
   }
 
-  va.render(*this);
+  m_shape_renderer->add(*this, shapes);
 }
 
 void
 GraphicsContext::push_cliprect(const geom::irect& rect_)
 {
+  flush();
+
   assert_gl();
 
   geom::irect rect = rect_;
@@ -551,7 +761,7 @@ GraphicsContext::push_cliprect(const geom::irect& rect_)
 
   glScissor(rect.left(), size().height() - rect.top() - rect.height(),
             rect.width(), rect.height());
-  glEnable(GL_SCISSOR_TEST);
+  m_state.enable(GL_SCISSOR_TEST);
 
   assert_gl();
 }
@@ -559,6 +769,8 @@ GraphicsContext::push_cliprect(const geom::irect& rect_)
 void
 GraphicsContext::pop_cliprect()
 {
+  flush();
+
   assert_gl();
 
   assert(!m_cliprects.empty());
@@ -574,7 +786,7 @@ GraphicsContext::pop_cliprect()
   }
   else
   {
-    glDisable(GL_SCISSOR_TEST);
+    m_state.disable(GL_SCISSOR_TEST);
   }
 
   assert_gl();
@@ -589,6 +801,8 @@ GraphicsContext::size() const
 void
 GraphicsContext::push_framebuffer(FramebufferPtr framebuffer)
 {
+  flush();
+
   assert_gl();
 
   if (framebuffers.empty()) {
@@ -604,6 +818,8 @@ GraphicsContext::push_framebuffer(FramebufferPtr framebuffer)
 void
 GraphicsContext::pop_framebuffer()
 {
+  flush();
+
   assert_gl();
 
   assert(!framebuffers.empty());
@@ -648,12 +864,14 @@ GraphicsContext::set_ortho(geom::isize const& size)
 void
 GraphicsContext::set_projection(glm::mat4 const& mat)
 {
+  flush_primitives();
   m_projection = mat;
 }
 
 void
 GraphicsContext::set_modelview(glm::mat4 const& mat)
 {
+  flush_primitives();
   m_modelview_stack.top() = mat;
 }
 
@@ -666,18 +884,21 @@ GraphicsContext::push_matrix()
 void
 GraphicsContext::pop_matrix()
 {
+  flush_primitives();
   m_modelview_stack.pop();
 }
 
 void
 GraphicsContext::mult_matrix(glm::mat4 const& mat)
 {
+  flush_primitives();
   m_modelview_stack.top() = m_modelview_stack.top() * mat;
 }
 
 void
 GraphicsContext::translate(float x, float y, float z)
 {
+  flush_primitives();
   m_modelview_stack.top() = glm::translate(m_modelview_stack.top(),
                                            glm::vec3(x, y, z));
 }
@@ -685,6 +906,7 @@ GraphicsContext::translate(float x, float y, float z)
 void
 GraphicsContext::scale(float x, float y, float z)
 {
+  flush_primitives();
   m_modelview_stack.top() = glm::scale(m_modelview_stack.top(),
                                        glm::vec3(x, y, z));
 }
@@ -692,6 +914,7 @@ GraphicsContext::scale(float x, float y, float z)
 void
 GraphicsContext::rotate(float degree, float x, float y, float z)
 {
+  flush_primitives();
   m_modelview_stack.top() = glm::rotate(m_modelview_stack.top(),
                                         glm::radians(degree), glm::vec3(x, y, z));
 }
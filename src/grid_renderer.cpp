@@ -0,0 +1,168 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "grid_renderer.hpp"
+
+#include <algorithm>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "assert_gl.hpp"
+#include "graphics_context.hpp"
+
+namespace wstdisplay {
+
+namespace {
+
+const char grid_vert_source[] = R"(#version 330 core
+
+out vec2 world_v;
+
+uniform mat4 inverse_modelviewprojection;
+
+void main()
+{
+  // see FullscreenTriangle
+  vec2 ndc = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+
+  // projection and modelview are affine, so the world position can
+  // be interpolated linearly
+  world_v = (inverse_modelviewprojection * vec4(ndc, 0.0, 1.0)).xy;
+  gl_Position = vec4(ndc, 0.0, 1.0);
+}
+)";
+
+const char grid_frag_source[] = R"(#version 330 core
+
+in vec2 world_v;
+
+layout(location = 0) out vec4 fragRGBAf;
+
+uniform vec2 offset;
+uniform vec2 cell;
+uniform vec4 color;
+uniform float line_width;
+uniform vec4 major_color;
+uniform float major_line_width;
+uniform float major_every;
+uniform vec2 fade;
+
+// coverage of the lines at the integers of coord, \a width in pixels
+float coverage(vec2 coord, vec2 pixel, float width)
+{
+  vec2 dist = abs(fract(coord + 0.5) - 0.5) / pixel;
+  vec2 alpha = clamp(width * 0.5 + 0.5 - dist, 0.0, 1.0);
+  return max(alpha.x, alpha.y);
+}
+
+float fade_out(vec2 pixel)
+{
+  if (fade.y <= fade.x) {
+    return 1.0;
+  }
+
+  float cell_size = 1.0 / max(pixel.x, pixel.y);
+  return smoothstep(fade.x, fade.y, cell_size);
+}
+
+void main()
+{
+  vec2 coord = (world_v - offset) / cell;
+
+  // size of a pixel in cells, taken before fract() so that it does
+  // not jump at the lines
+  vec2 pixel = max(fwidth(coord), vec2(1e-6));
+
+  vec4 result = vec4(color.rgb, color.a * coverage(coord, pixel, line_width) * fade_out(pixel));
+
+  if (major_every > 0.0) {
+    vec2 major_coord = coord / major_every;
+    vec2 major_pixel = pixel / major_every;
+    float major = coverage(major_coord, major_pixel, major_line_width) * fade_out(major_pixel);
+    result = mix(result, vec4(major_color.rgb, 1.0), major);
+    result.a = max(result.a * (1.0 - major), major_color.a * major);
+  }
+
+  if (result.a <= 0.0) {
+    discard;
+  }
+
+  fragRGBAf = result;
+}
+)";
+
+} // namespace
+
+GridRenderer::GridRenderer() :
+  m_program()
+{
+  assert_gl();
+
+  m_program = ShaderProgram::from_string(grid_vert_source, grid_frag_source);
+
+  assert_gl();
+}
+
+void
+GridRenderer::draw(GraphicsContext& gc, Grid const& grid)
+{
+  if (grid.size.width() <= 0.0f || grid.size.height() <= 0.0f) {
+    return;
+  }
+
+  GL_DEBUG_SCOPE("GridRenderer::draw");
+
+  gc.flush();
+
+  GLStateTracker& state = gc.get_state();
+  state.use_program(m_program);
+  state.disable(GL_DEPTH_TEST);
+  state.enable(GL_BLEND);
+  state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  static constexpr ShaderName inverse_modelviewprojection_name("inverse_modelviewprojection");
+  static constexpr ShaderName offset_name("offset");
+  static constexpr ShaderName cell_name("cell");
+  static constexpr ShaderName color_name("color");
+  static constexpr ShaderName line_width_name("line_width");
+  static constexpr ShaderName major_color_name("major_color");
+  static constexpr ShaderName major_line_width_name("major_line_width");
+  static constexpr ShaderName major_every_name("major_every");
+  static constexpr ShaderName fade_name("fade");
+
+  glm::mat4 const inverse_modelviewprojection = glm::inverse(gc.get_projection() * gc.get_modelview());
+  glUniformMatrix4fv(m_program->get_uniform_location(inverse_modelviewprojection_name),
+                     1, GL_FALSE, glm::value_ptr(inverse_modelviewprojection));
+
+  glUniform2f(m_program->get_uniform_location(offset_name), grid.offset.x(), grid.offset.y());
+  glUniform2f(m_program->get_uniform_location(cell_name), grid.size.width(), grid.size.height());
+  glUniform4f(m_program->get_uniform_location(color_name),
+              grid.color.r, grid.color.g, grid.color.b, grid.color.a);
+  glUniform1f(m_program->get_uniform_location(line_width_name), grid.line_width);
+  glUniform4f(m_program->get_uniform_location(major_color_name),
+              grid.major_color.r, grid.major_color.g, grid.major_color.b, grid.major_color.a);
+  glUniform1f(m_program->get_uniform_location(major_line_width_name), grid.major_line_width);
+  glUniform1f(m_program->get_uniform_location(major_every_name),
+              static_cast<float>(std::max(grid.major_every, 0)));
+  glUniform2f(m_program->get_uniform_location(fade_name),
+              grid.fade_start, grid.fade_end);
+
+  gc.get_fullscreen_triangle().draw(gc);
+}
+
+} // namespace wstdisplay
+
+/* EOF */
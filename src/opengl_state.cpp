@@ -190,9 +190,6 @@ OpenGLState::activate()
   OpenGLState* global_state = OpenGLState::global();
   assert(global_state);
 
-  // always apply color since it might have got changed between a glBegin/glEnd
-  glColor4f(impl->color.r, impl->color.g, impl->color.b, impl->color.a);
-
   for(std::map<GLenum, bool>::iterator i = impl->state.begin();
       i != impl->state.end(); ++i)
   {
@@ -230,7 +227,6 @@ OpenGLState::activate()
         {
           case GL_TEXTURE_2D:
             glBindTexture(GL_TEXTURE_2D, impl->texture[i]->get_handle());
-            glEnable(GL_TEXTURE_2D);
             break;
 
           default:
@@ -240,9 +236,8 @@ OpenGLState::activate()
       }
       else
       {
-        // FIXME: Hacky, should disable only the right target
+        // FIXME: Hacky, should unbind only the right target
         glBindTexture(GL_TEXTURE_2D, 0);
-        glDisable(GL_TEXTURE_2D);
 
         global_state->impl->texture[i] = impl->texture[i];
       }
@@ -78,6 +78,10 @@ OpenGLWindow::OpenGLWindow(wstsys::System& system,
   SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
   SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
 
+  if (params.debug) {
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+  }
+
   uint32_t flags = SDL_WINDOW_OPENGL;
 
   if (m_mode == Mode::Fullscreen) {
@@ -124,6 +128,10 @@ OpenGLWindow::OpenGLWindow(wstsys::System& system,
     glEnable(GL_MULTISAMPLE);
   }
 
+  if (params.debug) {
+    install_gl_debug_callback();
+  }
+
   assert_gl();
 
   OpenGLState::init();
@@ -266,7 +274,14 @@ OpenGLWindow::swap_buffers()
 {
   assert(m_window != nullptr);
 
+  m_gc->flush();
   SDL_GL_SwapWindow(m_window);
+
+  // frame boundary: stats start over and state changed by the
+  // application between frames is picked up again
+  m_gc->get_state().invalidate();
+  m_gc->get_state().reset_stats();
+  m_gc->get_va().reset_stats();
 }
 
 surf::SoftwareSurface
@@ -274,6 +289,8 @@ OpenGLWindow::screenshot() const
 {
   assert(m_gc != nullptr);
 
+  m_gc->flush();
+
   GLint viewport[4];
   glGetIntegerv(GL_VIEWPORT, viewport);
 
@@ -0,0 +1,221 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "rect_packer.hpp"
+
+#include <algorithm>
+#include <assert.h>
+#include <cstddef>
+#include <limits>
+
+namespace wstdisplay {
+
+namespace {
+
+bool contains(geom::irect const& outer, geom::irect const& inner)
+{
+  return
+    inner.left()   >= outer.left()  &&
+    inner.top()    >= outer.top()   &&
+    inner.right()  <= outer.right() &&
+    inner.bottom() <= outer.bottom();
+}
+
+bool overlaps(geom::irect const& lhs, geom::irect const& rhs)
+{
+  return
+    lhs.left() < rhs.right()  && rhs.left() < lhs.right() &&
+    lhs.top()  < rhs.bottom() && rhs.top()  < lhs.bottom();
+}
+
+} // namespace
+
+RectPacker::RectPacker(geom::isize const& size) :
+  m_size(size),
+  m_free_rects(),
+  m_new_rects(),
+  m_used_area(0),
+  m_count(0)
+{
+  clear();
+}
+
+void
+RectPacker::clear()
+{
+  m_free_rects.clear();
+  m_free_rects.emplace_back(geom::ipoint(0, 0), m_size);
+  m_used_area = 0;
+  m_count = 0;
+}
+
+std::optional<geom::irect>
+RectPacker::insert(geom::isize const& size)
+{
+  if (size.width() <= 0 || size.height() <= 0) {
+    return std::nullopt;
+  }
+
+  int best_short = std::numeric_limits<int>::max();
+  int best_long = std::numeric_limits<int>::max();
+  std::optional<geom::irect> best;
+
+  for (geom::irect const& free_rect : m_free_rects)
+  {
+    if (size.width() <= free_rect.width() && size.height() <= free_rect.height())
+    {
+      int const leftover_x = free_rect.width() - size.width();
+      int const leftover_y = free_rect.height() - size.height();
+      int const short_side = std::min(leftover_x, leftover_y);
+      int const long_side = std::max(leftover_x, leftover_y);
+
+      if (short_side < best_short || (short_side == best_short && long_side < best_long))
+      {
+        best_short = short_side;
+        best_long = long_side;
+        best = geom::irect(geom::ipoint(free_rect.left(), free_rect.top()), size);
+      }
+    }
+  }
+
+  if (best) {
+    split(*best);
+
+    m_used_area += static_cast<int64_t>(size.width()) * size.height();
+    m_count += 1;
+  }
+
+  return best;
+}
+
+void
+RectPacker::free(geom::irect const& rect)
+{
+  assert(m_count > 0);
+
+  m_used_area -= static_cast<int64_t>(rect.width()) * rect.height();
+  m_count -= 1;
+
+  if (m_count == 0) {
+    clear();
+    return;
+  }
+
+  // grow the freed rect as long as a neighbour lines up with it
+  geom::irect merged = rect;
+  bool grown = true;
+  while (grown)
+  {
+    grown = false;
+    for (geom::irect const& free_rect : m_free_rects)
+    {
+      if (free_rect.top() == merged.top() && free_rect.bottom() == merged.bottom() &&
+          (free_rect.right() == merged.left() || free_rect.left() == merged.right())) {
+        merged = geom::irect(std::min(merged.left(), free_rect.left()), merged.top(),
+                             std::max(merged.right(), free_rect.right()), merged.bottom());
+        grown = true;
+      } else if (free_rect.left() == merged.left() && free_rect.right() == merged.right() &&
+                 (free_rect.bottom() == merged.top() || free_rect.top() == merged.bottom())) {
+        merged = geom::irect(merged.left(), std::min(merged.top(), free_rect.top()),
+                             merged.right(), std::max(merged.bottom(), free_rect.bottom()));
+        grown = true;
+      }
+    }
+  }
+
+  // the free rects that were swallowed are redundant now, the merged
+  // one can't be inside any of them, as it covers space that was used
+  std::erase_if(m_free_rects, [&merged](geom::irect const& free_rect) {
+    return contains(merged, free_rect);
+  });
+  m_free_rects.push_back(merged);
+}
+
+float
+RectPacker::get_occupancy() const
+{
+  int64_t const area = static_cast<int64_t>(m_size.width()) * m_size.height();
+  return area ? static_cast<float>(static_cast<double>(m_used_area) / static_cast<double>(area)) : 0.0f;
+}
+
+void
+RectPacker::split(geom::irect const& used)
+{
+  m_new_rects.clear();
+
+  for (size_t i = 0; i < m_free_rects.size();)
+  {
+    geom::irect const free_rect = m_free_rects[i];
+
+    if (!overlaps(free_rect, used)) {
+      ++i;
+      continue;
+    }
+
+    // up to four maximal rects remain around the used one
+    if (used.left() > free_rect.left()) {
+      m_new_rects.emplace_back(free_rect.left(), free_rect.top(), used.left(), free_rect.bottom());
+    }
+    if (used.right() < free_rect.right()) {
+      m_new_rects.emplace_back(used.right(), free_rect.top(), free_rect.right(), free_rect.bottom());
+    }
+    if (used.top() > free_rect.top()) {
+      m_new_rects.emplace_back(free_rect.left(), free_rect.top(), free_rect.right(), used.top());
+    }
+    if (used.bottom() < free_rect.bottom()) {
+      m_new_rects.emplace_back(free_rect.left(), used.bottom(), free_rect.right(), free_rect.bottom());
+    }
+
+    // order doesn't matter, so swap with the last instead of erasing
+    m_free_rects[i] = m_free_rects.back();
+    m_free_rects.pop_back();
+  }
+
+  size_t const first_new = m_free_rects.size();
+  m_free_rects.insert(m_free_rects.end(), m_new_rects.begin(), m_new_rects.end());
+  prune(first_new);
+}
+
+void
+RectPacker::prune(size_t first_new)
+{
+  // the old free rects were pruned already, so only the new ones
+  // can be redundant, after free() an old one might be as well, but
+  // that only costs a bit of time
+  for (size_t i = first_new; i < m_free_rects.size();)
+  {
+    bool redundant = false;
+    for (size_t j = 0; j < m_free_rects.size(); ++j)
+    {
+      // of two equal rects keep the one with the lower index
+      if (j != i && contains(m_free_rects[j], m_free_rects[i]) &&
+          (j < i || !contains(m_free_rects[i], m_free_rects[j]))) {
+        redundant = true;
+        break;
+      }
+    }
+
+    if (redundant) {
+      m_free_rects.erase(m_free_rects.begin() + static_cast<std::ptrdiff_t>(i));
+    } else {
+      ++i;
+    }
+  }
+}
+
+} // namespace wstdisplay
+
+/* EOF */
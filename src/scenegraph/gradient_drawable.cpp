@@ -16,71 +16,203 @@
 
 #include "scenegraph/gradient_drawable.hpp"
 
+#include <algorithm>
+#include <stdint.h>
+
 #include <GL/glew.h>
+#include <glm/gtc/type_ptr.hpp>
 
+#include "assert_gl.hpp"
 #include "graphics_context.hpp"
 
 namespace wstdisplay {
 
+namespace {
+
+/** texels in the lookup texture */
+constexpr int lut_size = 256;
+
+/** floats per gradient band in m_colors */
+constexpr int band_size = 3 + 4 + 4 + 2;
+
+surf::Color
+mix(surf::Color const& lhs, surf::Color const& rhs, float t)
+{
+  return surf::Color(lhs.r + (rhs.r - lhs.r) * t,
+                     lhs.g + (rhs.g - lhs.g) * t,
+                     lhs.b + (rhs.b - lhs.b) * t,
+                     lhs.a + (rhs.a - lhs.a) * t);
+}
+
+} // namespace
+
 GradientDrawable::GradientDrawable(std::vector<float> colors)
   : Drawable(glm::vec2(0, 0), -1000),
     m_array(new VertexArrayDrawable(glm::vec2(0, 0), -1000, glm::mat4(1.0))),
-    m_colors(std::move(colors))
+    m_colors(std::move(colors)),
+    m_size(),
+    m_array_dirty(true),
+    m_lut_dirty(true),
+    m_use_lut(false),
+    m_lut()
 {
+  m_array->set_static(true);
+}
+
+void
+GradientDrawable::set_colors(std::vector<float> colors)
+{
+  m_colors = std::move(colors);
+  m_array_dirty = true;
+  m_lut_dirty = true;
 }
 
 void
 GradientDrawable::render(GraphicsContext& gc, unsigned int mask)
 {
+  if (m_use_lut) {
+    render_lut(gc);
+    return;
+  }
+
+  // the geometry only depends on the screen size and the colors
+  if (m_array_dirty || gc.size() != m_size) {
+    build_array(gc);
+  }
+
+  gc.push_matrix();
+  gc.set_modelview(glm::mat4(1.0f));
+  m_array->render(gc, mask);
+  gc.pop_matrix();
+}
+
+void
+GradientDrawable::build_array(GraphicsContext& gc)
+{
+  m_size = gc.size();
+  m_array_dirty = false;
   m_array->clear();
-  if (!m_colors.empty())
+
+  geom::frect rect(0.0f, 0.0f,
+                   static_cast<float>(gc.size().width()),
+                   static_cast<float>(gc.size().height()));
+
+  m_array->set_mode(GL_TRIANGLE_STRIP);
+  m_array->set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  for(int i = 0; i + band_size <= int(m_colors.size()); i += band_size)
+  {
+    const float& start    = m_colors[i + 0];
+    const float& midpoint = m_colors[i + 1];
+    const float& end      = m_colors[i + 2];
+    const surf::Color color1(m_colors[i + 3], m_colors[i + 4], m_colors[i + 5], m_colors[i + 6]);
+    const surf::Color color2(m_colors[i + 7], m_colors[i + 8], m_colors[i + 9], m_colors[i + 10]);
+    const surf::Color midcolor = mix(color1, color2, 0.5f);
+
+    // v2
+    m_array->color(color1);
+    m_array->vertex(rect.right(), rect.top() + start * rect.height());
+    // v1
+    m_array->color(color1);
+    m_array->vertex(rect.left(), rect.top() + start * rect.height());
+
+    // v4
+    m_array->color(midcolor);
+    m_array->vertex(rect.right(), rect.top() + midpoint * rect.height());
+    // v3
+    m_array->color(midcolor);
+    m_array->vertex(rect.left(), rect.top() + midpoint * rect.height());
+
+    // v6
+    m_array->color(color2);
+    m_array->vertex(rect.right(), rect.top() + end * rect.height());
+    // v5
+    m_array->color(color2);
+    m_array->vertex(rect.left(), rect.top() + end * rect.height());
+  }
+}
+
+void
+GradientDrawable::build_lut()
+{
+  m_lut_dirty = false;
+
+  // the same piecewise linear function the triangle strip produces,
+  // outside of the first and last stop nothing is drawn
+  std::vector<float> positions;
+  std::vector<surf::Color> colors;
+  for(int i = 0; i + band_size <= int(m_colors.size()); i += band_size)
   {
-    geom::frect rect(0.0f, 0.0f,
-                     static_cast<float>(gc.size().width()),
-                     static_cast<float>(gc.size().height()));
+    const surf::Color color1(m_colors[i + 3], m_colors[i + 4], m_colors[i + 5], m_colors[i + 6]);
+    const surf::Color color2(m_colors[i + 7], m_colors[i + 8], m_colors[i + 9], m_colors[i + 10]);
 
-    m_array->set_mode(GL_TRIANGLE_STRIP);
-    m_array->set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    positions.insert(positions.end(), { m_colors[i + 0], m_colors[i + 1], m_colors[i + 2] });
+    colors.insert(colors.end(), { color1, mix(color1, color2, 0.5f), color2 });
+  }
 
-    for(int i = 0; i < int(m_colors.size()); i += (3 + 4 + 4 + 2))
+  SoftwareSurface image = SoftwareSurface::create(surf::PixelFormat::RGBA8, geom::isize(lut_size, 1));
+  uint8_t* data = static_cast<uint8_t*>(image.get_data());
+
+  size_t k = 0;
+  for (int x = 0; x < lut_size; ++x)
+  {
+    float const t = (static_cast<float>(x) + 0.5f) / static_cast<float>(lut_size);
+
+    surf::Color color(0.0f, 0.0f, 0.0f, 0.0f);
+    if (!positions.empty() && t >= positions.front() && t <= positions.back())
     {
-      const float& start    = m_colors[i + 0];
-      const float& midpoint = m_colors[i + 1];
-      const float& end      = m_colors[i + 2];
-      const surf::Color color1(m_colors[i + 3], m_colors[i + 4], m_colors[i + 5], m_colors[i + 6]);
-      const surf::Color color2(m_colors[i + 7], m_colors[i + 8], m_colors[i + 9], m_colors[i + 10]);
-      const surf::Color midcolor((color1.r + color2.r)/2,
-                           (color1.g + color2.g)/2,
-                           (color1.b + color2.b)/2,
-                           (color1.a + color2.a)/2);
-
-      // v2
-      m_array->color(color1);
-      m_array->vertex(rect.right(), rect.top() + start * rect.height());
-      // v1
-      m_array->color(color1);
-      m_array->vertex(rect.left(), rect.top() + start * rect.height());
-
-      // v4
-      m_array->color(midcolor);
-      m_array->vertex(rect.right(), rect.top() + midpoint * rect.height());
-      // v3
-      m_array->color(midcolor);
-      m_array->vertex(rect.left(), rect.top() + midpoint * rect.height());
-
-      // v6
-      m_array->color(color2);
-      m_array->vertex(rect.right(), rect.top() + end * rect.height());
-      // v5
-      m_array->color(color2);
-      m_array->vertex(rect.left(), rect.top() + end * rect.height());
+      while (k + 2 < positions.size() && t > positions[k + 1]) {
+        ++k;
+      }
+
+      float const span = positions[k + 1] - positions[k];
+      color = (span > 0.0f) ? mix(colors[k], colors[k + 1], (t - positions[k]) / span) : colors[k + 1];
     }
+
+    RGBA8 const rgba = RGBA8::from_color(color);
+    data[x * 4 + 0] = rgba.r;
+    data[x * 4 + 1] = rgba.g;
+    data[x * 4 + 2] = rgba.b;
+    data[x * 4 + 3] = rgba.a;
   }
 
-  gc.push_matrix();
-  gc.set_modelview(glm::mat4(1.0f));
-  m_array->render(gc, mask);
-  gc.pop_matrix();
+  if (!m_lut) {
+    m_lut = Texture::create(GL_TEXTURE_2D, geom::isize(lut_size, 1));
+  }
+  m_lut->put(image, 0, 0);
+}
+
+void
+GradientDrawable::render_lut(GraphicsContext& gc)
+{
+  GL_DEBUG_SCOPE("GradientDrawable::render_lut");
+
+  if (m_lut_dirty) {
+    build_lut();
+  }
+
+  gc.flush();
+
+  ShaderProgramPtr const& program = gc.get_gradient_program();
+
+  GLStateTracker& state = gc.get_state();
+  state.use_program(program);
+  state.disable(GL_DEPTH_TEST);
+  state.enable(GL_BLEND);
+  state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  state.bind_texture(0, m_lut);
+
+  static constexpr ShaderName inverse_projection_name("inverse_projection");
+  static constexpr ShaderName height_name("height");
+  static constexpr ShaderName lut_name("lut");
+
+  glm::mat4 const inverse_projection = glm::inverse(gc.get_projection());
+  glUniformMatrix4fv(program->get_uniform_location(inverse_projection_name),
+                     1, GL_FALSE, glm::value_ptr(inverse_projection));
+  glUniform1f(program->get_uniform_location(height_name), static_cast<float>(gc.size().height()));
+  glUniform1i(program->get_uniform_location(lut_name), 0);
+
+  gc.get_fullscreen_triangle().draw(gc);
 }
 
 } // namespace wstdisplay
@@ -16,6 +16,8 @@
 
 #include "scenegraph/shader_drawable.hpp"
 
+#include "graphics_context.hpp"
+
 namespace wstdisplay {
 
 ShaderDrawable::ShaderDrawable() :
@@ -28,10 +30,12 @@ ShaderDrawable::ShaderDrawable() :
 void
 ShaderDrawable::render(GraphicsContext& gc, unsigned int mask)
 {
-  glUseProgram(m_shader->get_handle());
+  gc.flush();
+  gc.get_state().use_program(m_shader);
   m_shader->set_uniform1i("texture", 0);
   m_drawables.render(gc, mask);
-  glUseProgram(0);
+  gc.flush();
+  gc.get_state().use_program(nullptr);
 }
 
 } // namespace wstdisplay
@@ -16,6 +16,8 @@
 
 #include "scenegraph/stencil_drawable.hpp"
 
+#include "graphics_context.hpp"
+
 namespace wstdisplay {
 
 namespace {
@@ -31,11 +33,13 @@ StencilDrawable::StencilDrawable() :
 void
 StencilDrawable::render(GraphicsContext& gc, unsigned int mask)
 {
+  gc.flush();
+
   if (g_stencil_enabled == 0)
   {
     g_stencil_enabled = 1;
 
-    glEnable(GL_STENCIL_TEST);
+    gc.get_state().enable(GL_STENCIL_TEST);
 
     // enable stencil and clear it
     glClearStencil(0);
@@ -57,6 +61,7 @@ StencilDrawable::render(GraphicsContext& gc, unsigned int mask)
   glEnable(GL_ALPHA_TEST);
   glAlphaFunc(GL_GREATER, 0.5f);
   m_stencil_group.render(gc, ~0u);
+  gc.flush();
   glDisable(GL_ALPHA_TEST);
 
   // render framebuffer content
@@ -65,6 +70,7 @@ StencilDrawable::render(GraphicsContext& gc, unsigned int mask)
   glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 
   m_drawable_group.render(gc, ~0u);
+  gc.flush();
 
   g_stencil_enabled -= 1;
 
@@ -74,7 +80,7 @@ StencilDrawable::render(GraphicsContext& gc, unsigned int mask)
     glStencilFunc(GL_ALWAYS, 0, 1);
     glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 
-    glDisable(GL_STENCIL_TEST);
+    gc.get_state().disable(GL_STENCIL_TEST);
   }
 }
 
@@ -16,12 +16,13 @@
 
 #include "scenegraph/vertex_array_drawable.hpp"
 
-#include <iostream>
+#include <algorithm>
+
 #include <glm/gtc/type_ptr.hpp>
 
 #include "assert_gl.hpp"
+#include "geometry_builder.hpp"
 #include "graphics_context.hpp"
-#include "opengl_state.hpp"
 
 namespace wstdisplay {
 
@@ -30,19 +31,30 @@ VertexArrayDrawable::VertexArrayDrawable() :
 {}
 
 VertexArrayDrawable::VertexArrayDrawable(geom::fpoint const& pos_, float z_pos_,
-                                         glm::mat4 const& modelview_) :
+                                         glm::mat4 const& modelview_,
+                                         std::pmr::memory_resource* resource) :
   Drawable(pos_, z_pos_, modelview_),
   m_program(),
   m_mode(GL_QUADS),
   m_blend_sfactor(GL_SRC_ALPHA),
   m_blend_dfactor(GL_ONE_MINUS_SRC_ALPHA),
   m_depth_test(false),
+  m_hdr(false),
+  m_static(false),
+  m_dirty(true),
+  m_static_va(),
+  m_static_first(0),
+  m_static_indices_offset(0),
   m_textures(),
-  m_colors(),
-  m_texcoords(),
-  m_normals(),
-  m_vertices(),
-  m_indices()
+  m_colors(resource),
+  m_hdr_colors(resource),
+  m_texcoords(resource),
+  m_normals(resource),
+  m_vertices(resource),
+  m_indices(resource),
+  m_max_index(0),
+  m_primitive_mode(GL_TRIANGLES),
+  m_primitive_first(-1)
 {
 }
 
@@ -52,16 +64,93 @@ VertexArrayDrawable::num_vertices() const
   return static_cast<int>(m_vertices.size()) / 3;
 }
 
+void
+VertexArrayDrawable::add_rects(std::span<RectColor const> rects)
+{
+  reserve(static_cast<int>(rects.size()) * 6);
+
+  for (RectColor const& rect : rects)
+  {
+    geom::frect const& r = rect.rect;
+
+    if (m_hdr) {
+      for (int i = 0; i < 6; ++i) {
+        color(rect.color);
+      }
+    } else {
+      m_colors.insert(m_colors.end(), 6, RGBA8::from_color(rect.color));
+    }
+
+    vertex(r.left(),  r.top());
+    vertex(r.right(), r.top());
+    vertex(r.right(), r.bottom());
+
+    vertex(r.left(),  r.top());
+    vertex(r.right(), r.bottom());
+    vertex(r.left(),  r.bottom());
+  }
+}
+
+void
+VertexArrayDrawable::add_lines(std::span<LineColor const> lines)
+{
+  reserve(static_cast<int>(lines.size()) * 2);
+
+  for (LineColor const& line : lines)
+  {
+    color(line.color); vertex(line.line.p1);
+    color(line.color); vertex(line.line.p2);
+  }
+}
+
+void
+VertexArrayDrawable::reserve(int count, bool texcoords)
+{
+  size_t const n = static_cast<size_t>(num_vertices() + count);
+
+  m_vertices.reserve(n * 3);
+  if (m_hdr) {
+    m_hdr_colors.reserve(n * 4);
+  } else {
+    m_colors.reserve(n);
+  }
+  if (texcoords) {
+    m_texcoords.reserve(n * 2);
+  }
+}
+
+void
+VertexArrayDrawable::transform(int first_vertex, glm::mat4 const& matrix)
+{
+  if (matrix == glm::mat4(1.0f)) {
+    return;
+  }
+
+  m_dirty = true;
+
+  for (size_t i = static_cast<size_t>(first_vertex) * 3; i < m_vertices.size(); i += 3)
+  {
+    glm::vec4 const v = matrix * glm::vec4(m_vertices[i + 0], m_vertices[i + 1], m_vertices[i + 2], 1.0f);
+    m_vertices[i + 0] = v.x;
+    m_vertices[i + 1] = v.y;
+    m_vertices[i + 2] = v.z;
+  }
+}
+
 void
 VertexArrayDrawable::clear()
 {
+  m_dirty = true;
   m_program = {};
-  m_textures.clear();
+  m_textures.fill({});
   m_colors.clear();
+  m_hdr_colors.clear();
   m_texcoords.clear();
   m_normals.clear();
   m_vertices.clear();
   m_indices.clear();
+  m_max_index = 0;
+  m_primitive_first = -1;
 }
 
 void
@@ -71,92 +160,116 @@ VertexArrayDrawable::render(GraphicsContext& gc, unsigned int mask)
     return;
   }
 
+  // keep the order with shapes still pending in the GraphicsContext
+  gc.flush();
+
   assert(m_mode != GL_QUADS);
+  assert(m_primitive_first < 0);
+
+  GL_DEBUG_SCOPE("VertexArrayDrawable::render");
 
   assert(m_texcoords.empty() || int(m_texcoords.size() / 2) == num_vertices());
   assert(m_normals.empty() || int(m_normals.size() / 3) == num_vertices());
-  assert(m_colors.empty() || int(m_colors.size() / 4) == num_vertices());
+  assert(m_colors.empty() || int(m_colors.size()) == num_vertices());
+  assert(m_hdr_colors.empty() || int(m_hdr_colors.size() / 4) == num_vertices());
 
-  assert_gl();
-  if (m_program) {
-    glUseProgram(m_program->get_handle());
-  } else {
-    glUseProgram(gc.get_default_shader()->get_handle());
-  }
-  assert_gl();
+  ShaderProgramPtr const& program = m_program ? m_program : gc.get_default_shader();
+  GLStateTracker& state = gc.get_state();
 
-  if (m_depth_test) {
-    glEnable(GL_DEPTH_TEST);
-  } else {
-    glDisable(GL_DEPTH_TEST);
-  }
   assert_gl();
 
-  glEnable(GL_BLEND);
-  glBlendFunc(m_blend_sfactor, m_blend_dfactor);
+  state.use_program(program);
+  state.set_enabled(GL_DEPTH_TEST, m_depth_test);
+  state.enable(GL_BLEND);
+  state.blend_func(m_blend_sfactor, m_blend_dfactor);
 
   if (m_texcoords.empty()) {
     // FIXME: hack
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gc.get_white_texture()->get_handle());
+    state.bind_texture(0, gc.get_white_texture());
   } else {
-    for (auto const& it : m_textures) {
-      glActiveTexture(GL_TEXTURE0 + it.first);
-      glBindTexture(GL_TEXTURE_2D, it.second->get_handle());
+    for (int unit = 0; unit < static_cast<int>(m_textures.size()); ++unit) {
+      if (m_textures[unit]) {
+        state.bind_texture(unit, m_textures[unit]);
+      }
     }
   }
 
   assert_gl();
 
-  if (m_colors.empty()) {
-    // FIXME: hack
-    m_colors.resize(num_vertices() * 4, 1.0f);
-  }
+  // 16 bit indices whenever they suffice
+  GLenum const index_type = (m_max_index <= 0xffff) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+  auto upload = [this, index_type](GLVertexArrays& va, GLint& first_out, GLintptr& indices_out) {
+    first_out = m_hdr ?
+      va.upload_hdr(m_vertices, m_texcoords, m_hdr_colors) :
+      va.upload(m_vertices, m_texcoords, m_colors);
+    indices_out = va.upload_indices(m_indices, index_type);
+  };
+
+  GLint first = 0;
+  GLintptr indices_offset = 0;
+  if (m_static) {
+    if (!m_static_va) {
+      m_static_va = std::make_unique<GLVertexArrays>(state, 0, GL_STATIC_DRAW);
+      m_dirty = true;
+    }
+
+    state.bind_vertex_array(m_static_va->get_vertex_array(m_hdr));
+
+    if (m_dirty) {
+      size_t const vertex_size = m_hdr ? sizeof(HDRStreamVertex) : sizeof(StreamVertex);
+      size_t const index_size = (index_type == GL_UNSIGNED_SHORT) ? sizeof(uint16_t) : sizeof(uint32_t);
+
+      m_static_va->set_capacity(static_cast<size_t>(num_vertices()) * vertex_size);
+      m_static_va->set_index_capacity(m_indices.size() * index_size);
+
+      upload(*m_static_va, m_static_first, m_static_indices_offset);
+      m_dirty = false;
+    } else {
+      m_static_va->apply_constant_color(m_hdr);
+    }
 
-  gc.get_va().bind();
-  gc.get_va().set_colors(m_colors);
-  gc.get_va().set_texcoords(m_texcoords);
-  // gc.get_va().set_normals(m_normals);
-  gc.get_va().set_positions(m_vertices);
+    first = m_static_first;
+    indices_offset = m_static_indices_offset;
+  } else {
+    state.bind_vertex_array(gc.get_va().get_vertex_array(m_hdr));
+    upload(gc.get_va(), first, indices_offset);
+  }
 
   gc.push_matrix();
   gc.mult_matrix(modelview);
 
   glm::mat4 modelviewprojection = gc.get_projection() * gc.get_modelview();
 
-  int loc = gc.get_default_shader()->get_uniform_location("modelviewprojection");
+  static constexpr ShaderName modelviewprojection_name("modelviewprojection");
+  static constexpr ShaderName diffuse_texture_name("diffuse_texture");
+
+  int loc = program->get_uniform_location(modelviewprojection_name);
   if (loc != -1) {
     glUniformMatrix4fv(loc, 1, false, glm::value_ptr(modelviewprojection));
-  } else {
-    std::cout << "BORK" << std::endl;
   }
 
-  loc = gc.get_default_shader()->get_uniform_location("diffuse_texture");
+  loc = program->get_uniform_location(diffuse_texture_name);
   if (loc != -1)
     glUniform1i(loc, 0);
 
-  // FIXME: Hack: make this configurable
-  if (m_mode == GL_LINES || m_mode == GL_LINE_LOOP) {
-    glLineWidth(2.0f);
-  }
-
   assert_gl();
 
   if (m_indices.empty()) {
     assert_gl();
-    glDrawArrays(m_mode, 0, num_vertices());
+    glDrawArrays(m_mode, first, num_vertices());
     assert_gl();
   } else {
     assert_gl();
-    glDrawElements(m_mode, static_cast<GLsizei>(m_indices.size()),
-                   GL_UNSIGNED_SHORT, m_indices.data());
+    glDrawElementsBaseVertex(m_mode, static_cast<GLsizei>(m_indices.size()), index_type,
+                             reinterpret_cast<void const*>(indices_offset), first);
     assert_gl();
   }
 
-  assert_gl();
-
-  if (m_mode == GL_LINES || m_mode == GL_LINE_LOOP) {
-    glLineWidth(1.0f);
+  if (m_static) {
+    // don't leave our own vertex array in the tracker, its name can
+    // get reused once this drawable is gone
+    state.bind_vertex_array(gc.get_va().get_vertex_array());
   }
 
   gc.pop_matrix();
@@ -164,6 +277,118 @@ VertexArrayDrawable::render(GraphicsContext& gc, unsigned int mask)
   assert_gl();
 }
 
+bool
+VertexArrayDrawable::get_batch_state(BatchState& state) const
+{
+  // multitextured, HDR and static geometry is left to render()
+  if (m_hdr || m_static ||
+      (!m_texcoords.empty() &&
+       (!m_textures[0] || m_textures[1] || m_textures[2] || m_textures[3]))) {
+    return false;
+  }
+
+  // indices are only rebased, not converted
+  if (!m_indices.empty() && list_mode(m_mode) != m_mode) {
+    return false;
+  }
+
+  switch (m_mode)
+  {
+    case GL_TRIANGLES:
+    case GL_TRIANGLE_FAN:
+    case GL_TRIANGLE_STRIP:
+      state.mode = GL_TRIANGLES;
+      break;
+
+    case GL_LINES:
+    case GL_LINE_LOOP:
+    case GL_LINE_STRIP:
+      state.mode = GL_LINES;
+      break;
+
+    case GL_POINTS:
+      state.mode = GL_POINTS;
+      break;
+
+    default:
+      return false;
+  }
+
+  state.program = m_program;
+  state.texture = m_texcoords.empty() ? TexturePtr() : m_textures[0];
+  state.blend_sfactor = m_blend_sfactor;
+  state.blend_dfactor = m_blend_dfactor;
+  state.depth_test = m_depth_test;
+
+  return true;
+}
+
+void
+VertexArrayDrawable::append_to_batch(VertexArrayDrawable& batch) const
+{
+  assert(m_primitive_first < 0);
+
+  uint32_t const base = static_cast<uint32_t>(batch.num_vertices());
+  uint32_t const n = static_cast<uint32_t>(num_vertices());
+
+  if (n == 0) {
+    return;
+  }
+
+  batch.m_dirty = true;
+
+  batch.m_vertices.insert(batch.m_vertices.end(), m_vertices.begin(), m_vertices.end());
+
+  if (!m_texcoords.empty()) {
+    batch.m_texcoords.insert(batch.m_texcoords.end(), m_texcoords.begin(), m_texcoords.end());
+  }
+
+  if (m_colors.empty()) {
+    batch.m_colors.insert(batch.m_colors.end(), n, RGBA8::white());
+  } else {
+    batch.m_colors.insert(batch.m_colors.end(), m_colors.begin(), m_colors.end());
+  }
+
+  // the batch is always indexed, fans, strips and loops are turned
+  // into lists so that they can be concatenated
+  if (m_indices.empty()) {
+    append_list_indices(m_mode, base, n, batch.m_indices);
+  } else {
+    for (uint32_t const idx : m_indices) {
+      batch.m_indices.push_back(base + idx);
+    }
+  }
+
+  batch.m_max_index = std::max(batch.m_max_index, base + n - 1);
+}
+
+void
+VertexArrayDrawable::begin(GLenum mode)
+{
+  assert(m_primitive_first < 0);
+  assert(list_mode(mode) == m_mode);
+
+  m_primitive_mode = mode;
+  m_primitive_first = num_vertices();
+}
+
+void
+VertexArrayDrawable::end()
+{
+  assert(m_primitive_first >= 0);
+
+  uint32_t const first = static_cast<uint32_t>(m_primitive_first);
+  uint32_t const count = static_cast<uint32_t>(num_vertices()) - first;
+
+  m_dirty = true;
+  append_list_indices(m_primitive_mode, first, count, m_indices);
+  if (count > 0) {
+    m_max_index = std::max(m_max_index, first + count - 1);
+  }
+
+  m_primitive_first = -1;
+}
+
 void
 VertexArrayDrawable::vertex(geom::fpoint const& vec, float z)
 {
@@ -181,6 +406,7 @@ VertexArrayDrawable::vertex(int x, int y, int z)
 void
 VertexArrayDrawable::vertex(float x, float y, float z)
 {
+  m_dirty = true;
   m_vertices.push_back(x + pos.x());
   m_vertices.push_back(y + pos.y());
   m_vertices.push_back(z);
@@ -189,6 +415,7 @@ VertexArrayDrawable::vertex(float x, float y, float z)
 void
 VertexArrayDrawable::texcoord(float u, float v)
 {
+  m_dirty = true;
   m_texcoords.push_back(u);
   m_texcoords.push_back(v);
 }
@@ -196,6 +423,7 @@ VertexArrayDrawable::texcoord(float u, float v)
 void
 VertexArrayDrawable::add_texcoords_from_rect(geom::frect const& rect)
 {
+  m_dirty = true;
   assert(m_mode == GL_TRIANGLES);
 
   // v1
@@ -222,6 +450,7 @@ VertexArrayDrawable::add_texcoords_from_rect(geom::frect const& rect)
 void
 VertexArrayDrawable::add_texcoords(std::span<float const> data)
 {
+  m_dirty = true;
   assert(data.size() % 2 == 0);
   m_texcoords.insert(m_texcoords.end(), data.begin(), data.end());
 }
@@ -229,20 +458,39 @@ VertexArrayDrawable::add_texcoords(std::span<float const> data)
 void
 VertexArrayDrawable::add_normals(std::span<float const> data)
 {
+  m_dirty = true;
   assert(data.size() % 3 == 0);
   m_normals.insert(m_normals.end(), data.begin(), data.end());
 }
 
 void
-VertexArrayDrawable::add_indices(std::span<unsigned short int const> data)
+VertexArrayDrawable::add_indices(std::span<uint16_t const> data)
+{
+  m_dirty = true;
+  assert(data.size() % 3 == 0);
+
+  for (uint16_t const idx : data) {
+    m_indices.push_back(idx);
+    m_max_index = std::max<uint32_t>(m_max_index, idx);
+  }
+}
+
+void
+VertexArrayDrawable::add_indices(std::span<uint32_t const> data)
 {
+  m_dirty = true;
   assert(data.size() % 3 == 0);
+
   m_indices.insert(m_indices.end(), data.begin(), data.end());
+  for (uint32_t const idx : data) {
+    m_max_index = std::max(m_max_index, idx);
+  }
 }
 
 void
 VertexArrayDrawable::add_vertices(std::span<float const> data)
 {
+  m_dirty = true;
   assert(data.size() % 3 == 0);
   m_vertices.insert(m_vertices.end(), data.begin(), data.end());
 }
@@ -250,6 +498,7 @@ VertexArrayDrawable::add_vertices(std::span<float const> data)
 void
 VertexArrayDrawable::normal(float x, float y, float z)
 {
+  m_dirty = true;
   m_normals.push_back(x);
   m_normals.push_back(y);
   m_normals.push_back(z);
@@ -258,10 +507,23 @@ VertexArrayDrawable::normal(float x, float y, float z)
 void
 VertexArrayDrawable::color(surf::Color const& color_)
 {
-  m_colors.push_back(color_.r);
-  m_colors.push_back(color_.g);
-  m_colors.push_back(color_.b);
-  m_colors.push_back(color_.a);
+  m_dirty = true;
+  if (m_hdr) {
+    m_hdr_colors.push_back(color_.r);
+    m_hdr_colors.push_back(color_.g);
+    m_hdr_colors.push_back(color_.b);
+    m_hdr_colors.push_back(color_.a);
+  } else {
+    m_colors.push_back(RGBA8::from_color(color_));
+  }
+}
+
+void
+VertexArrayDrawable::color(RGBA8 color_)
+{
+  m_dirty = true;
+  assert(!m_hdr);
+  m_colors.push_back(color_);
 }
 
 void
@@ -273,6 +535,7 @@ VertexArrayDrawable::set_texture(TexturePtr texture)
 void
 VertexArrayDrawable::set_texture(int unit, TexturePtr texture)
 {
+  assert(unit >= 0 && unit < static_cast<int>(m_textures.size()));
   m_textures[unit] = texture;
 }
 
@@ -289,6 +552,25 @@ VertexArrayDrawable::set_depth_test(bool depth_test)
   m_depth_test = depth_test;
 }
 
+void
+VertexArrayDrawable::set_hdr(bool hdr)
+{
+  assert(m_colors.empty() && m_hdr_colors.empty());
+  m_hdr = hdr;
+  m_dirty = true;
+}
+
+void
+VertexArrayDrawable::set_static(bool value)
+{
+  m_static = value;
+  m_dirty = true;
+
+  if (!m_static) {
+    m_static_va.reset();
+  }
+}
+
 void
 VertexArrayDrawable::set_program(ShaderProgramPtr program)
 {
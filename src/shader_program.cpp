@@ -16,13 +16,16 @@
 
 #include "shader_program.hpp"
 
+#include <algorithm>
 #include <assert.h>
-#include <iostream>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
+#include <logmich/log.hpp>
+
 #include "assert_gl.hpp"
-#include "assert_gl.hpp"
+#include "gl_vertex_arrays.hpp"
 #include "shader_object.hpp"
 
 namespace wstdisplay {
@@ -62,7 +65,9 @@ ShaderProgram::create()
 }
 
 ShaderProgram::ShaderProgram() :
- m_handle(0)
+  m_handle(0),
+  m_uniforms(),
+  m_attribs()
 {
   m_handle = glCreateProgram();
 }
@@ -82,41 +87,104 @@ ShaderProgram::attach(ShaderObjectPtr obj)
 void
 ShaderProgram::link()
 {
+  // give the standard attributes the locations used by GLVertexArrays,
+  // explicit layout qualifiers in the shader take precedence
+  glBindAttribLocation(m_handle, static_cast<GLuint>(VertexAttrib::POSITION), "position");
+  glBindAttribLocation(m_handle, static_cast<GLuint>(VertexAttrib::TEXCOORD), "texcoord");
+  glBindAttribLocation(m_handle, static_cast<GLuint>(VertexAttrib::DIFFUSE), "diffuse");
+
   glLinkProgram(m_handle);
   if (!get_link_status())
   {
     throw std::runtime_error(get_info_log());
   }
+
+  update_locations();
 }
 
-GLint
-ShaderProgram::get_uniform_location(const char* name) const
+void
+ShaderProgram::update_locations()
 {
-  GLint loc;
-
-  loc = glGetUniformLocation(m_handle, name);
+  m_uniforms.clear();
+  m_attribs.clear();
+
+  GLint max_length = 0;
+  glGetProgramiv(m_handle, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+  GLint attrib_max_length = 0;
+  glGetProgramiv(m_handle, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &attrib_max_length);
+  std::vector<GLchar> buffer(std::max(max_length, attrib_max_length) + 1);
+
+  auto add = [](std::vector<Location>& cache, std::string const& name, GLint location) {
+    cache.push_back(Location{ShaderName::hash(name), name, location});
+  };
+
+  GLint count = 0;
+  glGetProgramiv(m_handle, GL_ACTIVE_UNIFORMS, &count);
+  for (GLint i = 0; i < count; ++i)
+  {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(m_handle, i, static_cast<GLsizei>(buffer.size()), &length, &size, &type, buffer.data());
+
+    std::string const name(buffer.data(), length);
+    add(m_uniforms, name, glGetUniformLocation(m_handle, name.c_str()));
+
+    // arrays are reported as "name[0]", make them available as "name"
+    // and with every element index too
+    if (name.ends_with("[0]")) {
+      std::string const base = name.substr(0, name.size() - 3);
+      add(m_uniforms, base, m_uniforms.back().location);
+      for (GLint element = 1; element < size; ++element) {
+        std::string const element_name = base + "[" + std::to_string(element) + "]";
+        add(m_uniforms, element_name, glGetUniformLocation(m_handle, element_name.c_str()));
+      }
+    }
+  }
 
-  if (loc == -1)
-    std::cout << "No such uniform named \"%s\"\n" << name << std::endl;
+  glGetProgramiv(m_handle, GL_ACTIVE_ATTRIBUTES, &count);
+  for (GLint i = 0; i < count; ++i)
+  {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveAttrib(m_handle, i, static_cast<GLsizei>(buffer.size()), &length, &size, &type, buffer.data());
+
+    std::string const name(buffer.data(), length);
+    add(m_attribs, name, glGetAttribLocation(m_handle, name.c_str()));
+    if (name.ends_with("[0]")) {
+      add(m_attribs, name.substr(0, name.size() - 3), m_attribs.back().location);
+    }
+  }
 
   assert_gl();
-
-  return loc;
 }
 
 GLint
-ShaderProgram::get_attrib_location(const char* name) const
+ShaderProgram::lookup(std::vector<Location>& cache, ShaderName const& name, const char* kind) const
 {
-  GLint loc;
-
-  loc = glGetAttribLocation(m_handle, name);
+  for (Location const& entry : cache) {
+    if (entry.hash == name.get_hash() && entry.name == name.get_name()) {
+      return entry.location;
+    }
+  }
 
-  if (loc == -1)
-    std::cout << "No such attrib named \"%s\"\n" << name << std::endl;
+  // remember the miss, so that it only gets reported once
+  log_warn("no such {} named \"{}\" in shader program {}", kind, name.get_name(), m_handle);
+  cache.push_back(Location{name.get_hash(), name.get_name(), -1});
+  return -1;
+}
 
-  assert_gl();
+GLint
+ShaderProgram::get_uniform_location(ShaderName const& name) const
+{
+  return lookup(m_uniforms, name, "uniform");
+}
 
-  return loc;
+GLint
+ShaderProgram::get_attrib_location(ShaderName const& name) const
+{
+  return lookup(m_attribs, name, "attrib");
 }
 
 GLuint
@@ -126,82 +194,66 @@ ShaderProgram::get_handle() const
 }
 
 void
-ShaderProgram::set_uniform1f(const char* name, GLfloat v0)
+ShaderProgram::set_uniform1f(ShaderName const& name, GLfloat v0)
 {
-  GLint location = glGetUniformLocation(m_handle, name);
-  if (location == -1)
-    std::cout << "No such uniform named \"" << name << "\"" << std::endl;
-  else
+  GLint location = get_uniform_location(name);
+  if (location != -1)
     glUniform1f(location, v0);
 }
 
 void
-ShaderProgram::set_uniform2f(const char* name, GLfloat v0, GLfloat v1)
+ShaderProgram::set_uniform2f(ShaderName const& name, GLfloat v0, GLfloat v1)
 {
-  GLint location = glGetUniformLocation(m_handle, name);
-  if (location == -1)
-    std::cout << "No such uniform named \"" << name << "\"" << std::endl;
-  else
+  GLint location = get_uniform_location(name);
+  if (location != -1)
     glUniform2f(location, v0, v1);
 }
 
 void
-ShaderProgram::set_uniform3f(const char* name, GLfloat v0, GLfloat v1, GLfloat v2)
+ShaderProgram::set_uniform3f(ShaderName const& name, GLfloat v0, GLfloat v1, GLfloat v2)
 {
-  GLint location = glGetUniformLocation(m_handle, name);
-  if (location == -1)
-    std::cout << "No such uniform named \"" << name << "\"" << std::endl;
-  else
+  GLint location = get_uniform_location(name);
+  if (location != -1)
     glUniform3f(location, v0, v1, v2);
 }
 
 void
-ShaderProgram::set_uniform4f(const char* name, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+ShaderProgram::set_uniform4f(ShaderName const& name, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
 {
-  GLint location = glGetUniformLocation(m_handle, name);
-  if (location == -1)
-    std::cout << "No such uniform named \"" << name << "\"" << std::endl;
-  else
+  GLint location = get_uniform_location(name);
+  if (location != -1)
     glUniform4f(location, v0, v1, v2, v3);
 }
 
 void
-ShaderProgram::set_uniform1i(const char* name, GLint v0)
+ShaderProgram::set_uniform1i(ShaderName const& name, GLint v0)
 {
-  GLint location = glGetUniformLocation(m_handle, name);
-  if (location == -1)
-    std::cout << "No such uniform named \"" << name << "\"" << std::endl;
-  else
+  GLint location = get_uniform_location(name);
+  if (location != -1)
     glUniform1i(location, v0);
 }
 
 void
-ShaderProgram::set_uniform2i(const char* name, GLint v0, GLint v1)
+ShaderProgram::set_uniform2i(ShaderName const& name, GLint v0, GLint v1)
 {
-  GLint location = glGetUniformLocation(m_handle, name);
-  if (location == -1)
-    std::cout << "No such uniform named \"" << name << "\"" << std::endl;
-  else
+  GLint location = get_uniform_location(name);
+  if (location != -1)
     glUniform2i(location, v0, v1);
 }
 
 void
-ShaderProgram::set_uniform3i(const char* name, GLint v0, GLint v1, GLint v2)
+ShaderProgram::set_uniform3i(ShaderName const& name, GLint v0, GLint v1, GLint v2)
 {
-  GLint location = glGetUniformLocation(m_handle, name);
-  if (location == -1)
-    std::cout << "No such uniform named \"" << name << "\"" << std::endl;
-  else
+  GLint location = get_uniform_location(name);
+  if (location != -1)
     glUniform3i(location, v0, v1, v2);
 }
 
 void
-ShaderProgram::set_uniform4i(const char* name, GLint v0, GLint v1, GLint v2, GLint v3)
+ShaderProgram::set_uniform4i(ShaderName const& name, GLint v0, GLint v1, GLint v2, GLint v3)
 {
-  GLint location = glGetUniformLocation(m_handle, name);
-  if (location == -1)
-    std::cout << "No such uniform named \"" << name << "\"" << std::endl;
-  else
+  GLint location = get_uniform_location(name);
+  if (location != -1)
     glUniform4i(location, v0, v1, v2, v3);
 }
 
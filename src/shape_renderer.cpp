@@ -0,0 +1,326 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "shape_renderer.hpp"
+
+#include <algorithm>
+#include <assert.h>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "assert_gl.hpp"
+#include "graphics_context.hpp"
+
+namespace wstdisplay {
+
+namespace {
+
+const char shape_vert_source[] = R"(#version 330 core
+
+layout(location = 0) in vec4 geometry;
+layout(location = 1) in vec4 params;
+layout(location = 2) in vec4 diffuse;
+layout(location = 3) in uint type;
+
+out vec2 local_v;
+flat out vec2 half_size_v;
+flat out vec4 params_v;
+flat out vec4 diffuse_v;
+flat out uint type_v;
+
+uniform mat4 modelviewprojection;
+
+// size of a pixel in local units
+uniform vec2 pixel_size;
+
+void main()
+{
+  // triangle strip over the quad from -1 to 1
+  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+
+  // leave room for the outer half of the stroke and two pixels of
+  // anti-aliased fringe
+  vec2 extent = geometry.zw + params.y * 0.5 + 2.0 * pixel_size;
+
+  local_v = corner * extent;
+  half_size_v = geometry.zw;
+  params_v = params;
+  diffuse_v = diffuse;
+  type_v = type;
+  gl_Position = modelviewprojection * vec4(geometry.xy + local_v, 0.0, 1.0);
+}
+)";
+
+const char shape_frag_source[] = R"(#version 330 core
+
+in vec2 local_v;
+flat in vec2 half_size_v;
+flat in vec4 params_v;
+flat in vec4 diffuse_v;
+flat in uint type_v;
+
+layout(location = 0) out vec4 fragRGBAf;
+
+float sd_round_box(vec2 p, vec2 b, float r)
+{
+  vec2 q = abs(p) - b + r;
+  return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - r;
+}
+
+float sd_segment(vec2 p, vec2 b)
+{
+  float h = clamp(dot(p, b) / dot(b, b), 0.0, 1.0);
+  return length(p - b * h);
+}
+
+float sd_pie(vec2 p, float r, float a0, float a1)
+{
+  float ds = min(sd_segment(p, vec2(cos(a0), sin(a0)) * r),
+                 sd_segment(p, vec2(cos(a1), sin(a1)) * r));
+  float dc = length(p) - r;
+
+  float a = mod(atan(p.y, p.x) - a0, 6.28318530718);
+  if (a <= a1 - a0) {
+    return dc > 0.0 ? dc : -min(-dc, ds);
+  } else {
+    // outside of the wedge the closest point is on one of its sides
+    return ds;
+  }
+}
+
+void main()
+{
+  float d;
+  if (type_v == 0u) { // CIRCLE
+    d = length(local_v) - half_size_v.x;
+  } else if (type_v == 1u) { // ARC
+    d = sd_pie(local_v, half_size_v.x, params_v.z, params_v.w);
+  } else if (type_v == 2u) { // ROUNDED_RECT
+    d = sd_round_box(local_v, half_size_v, min(params_v.x, min(half_size_v.x, half_size_v.y)));
+  } else { // CAPSULE
+    d = sd_round_box(local_v, half_size_v, min(half_size_v.x, half_size_v.y));
+  }
+
+  if (params_v.y > 0.0) {
+    d = abs(d) - params_v.y * 0.5;
+  }
+
+  float alpha = clamp(0.5 - d / max(fwidth(d), 1e-4), 0.0, 1.0);
+  if (alpha <= 0.0) {
+    discard;
+  }
+
+  fragRGBAf = vec4(diffuse_v.rgb, diffuse_v.a * alpha);
+}
+)";
+
+} // namespace
+
+Shape
+Shape::circle(geom::fpoint const& pos, float radius, surf::Color const& color, float stroke)
+{
+  Shape shape;
+  shape.type = ShapeType::CIRCLE;
+  shape.x = pos.x();
+  shape.y = pos.y();
+  shape.half_width = radius;
+  shape.half_height = radius;
+  shape.stroke = stroke;
+  shape.color = color;
+  return shape;
+}
+
+Shape
+Shape::arc(geom::fpoint const& pos, float radius, float start, float end,
+           surf::Color const& color, float stroke)
+{
+  Shape shape = circle(pos, radius, color, stroke);
+  shape.type = ShapeType::ARC;
+  shape.start = std::min(start, end);
+  shape.end = std::max(start, end);
+  return shape;
+}
+
+Shape
+Shape::rounded_rect(geom::frect const& rect, float radius, surf::Color const& color, float stroke)
+{
+  Shape shape;
+  shape.type = ShapeType::ROUNDED_RECT;
+  shape.x = rect.left() + rect.width() / 2.0f;
+  shape.y = rect.top() + rect.height() / 2.0f;
+  shape.half_width = rect.width() / 2.0f;
+  shape.half_height = rect.height() / 2.0f;
+  shape.radius = radius;
+  shape.stroke = stroke;
+  shape.color = color;
+  return shape;
+}
+
+Shape
+Shape::capsule(geom::frect const& rect, surf::Color const& color, float stroke)
+{
+  Shape shape = rounded_rect(rect, 0.0f, color, stroke);
+  shape.type = ShapeType::CAPSULE;
+  return shape;
+}
+
+ShapeRenderer::ShapeRenderer(GLStateTracker& state, size_t capacity) :
+  m_program(),
+  m_vao(),
+  m_buffer(),
+  m_capacity(capacity - capacity % sizeof(ShapeInstance)),
+  m_offset(0),
+  m_instances(),
+  m_modelviewprojection(1.0f)
+{
+  assert_gl();
+
+  m_program = ShaderProgram::from_string(shape_vert_source, shape_frag_source);
+
+  glGenVertexArrays(1, &m_vao);
+  glGenBuffers(1, &m_buffer);
+
+  state.bind_vertex_array(m_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_capacity), nullptr, GL_STREAM_DRAW);
+
+  for (GLuint loc = 0; loc < 4; ++loc) {
+    glEnableVertexAttribArray(loc);
+    glVertexAttribDivisor(loc, 1);
+  }
+
+  assert_gl();
+}
+
+ShapeRenderer::~ShapeRenderer()
+{
+  glDeleteBuffers(1, &m_buffer);
+  glDeleteVertexArrays(1, &m_vao);
+}
+
+void
+ShapeRenderer::add(GraphicsContext& gc, std::span<Shape const> shapes)
+{
+  glm::mat4 const modelviewprojection = gc.get_projection() * gc.get_modelview();
+
+  if (!m_instances.empty() && modelviewprojection != m_modelviewprojection) {
+    flush(gc);
+  }
+  m_modelviewprojection = modelviewprojection;
+
+  m_instances.reserve(m_instances.size() + shapes.size());
+  for (Shape const& shape : shapes)
+  {
+    ShapeInstance instance;
+
+    instance.x = shape.x;
+    instance.y = shape.y;
+    instance.half_width = shape.half_width;
+    instance.half_height = shape.half_height;
+    instance.radius = shape.radius;
+    instance.stroke = shape.stroke;
+    instance.start = glm::radians(shape.start);
+    instance.end = glm::radians(shape.end);
+    instance.color = RGBA8::from_color(shape.color);
+    instance.type = static_cast<uint32_t>(shape.type);
+
+    m_instances.push_back(instance);
+  }
+}
+
+size_t
+ShapeRenderer::upload()
+{
+  size_t const bytes = m_instances.size() * sizeof(ShapeInstance);
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+
+  if (bytes > m_capacity) {
+    m_capacity = std::max(bytes, m_capacity * 2);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_capacity), nullptr, GL_STREAM_DRAW);
+    m_offset = 0;
+  } else if (m_offset + bytes > m_capacity) {
+    // orphan the storage instead of waiting for the GPU
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_capacity), nullptr, GL_STREAM_DRAW);
+    m_offset = 0;
+  }
+
+  void* const ptr = glMapBufferRange(GL_ARRAY_BUFFER, static_cast<GLintptr>(m_offset), static_cast<GLsizeiptr>(bytes),
+                                     GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+  assert_gl();
+
+  std::copy(m_instances.begin(), m_instances.end(), static_cast<ShapeInstance*>(ptr));
+
+  glUnmapBuffer(GL_ARRAY_BUFFER);
+  assert_gl();
+
+  size_t const offset = m_offset;
+  m_offset += bytes;
+  return offset;
+}
+
+void
+ShapeRenderer::flush(GraphicsContext& gc)
+{
+  if (m_instances.empty()) {
+    return;
+  }
+
+  GL_DEBUG_SCOPE("ShapeRenderer::flush");
+
+  GLStateTracker& state = gc.get_state();
+  state.use_program(m_program);
+  state.disable(GL_DEPTH_TEST);
+  state.enable(GL_BLEND);
+  state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  state.bind_vertex_array(m_vao);
+
+  size_t const offset = upload();
+
+  // GL 3.3 has no base instance, so point the attributes at the
+  // freshly written range instead
+  GLsizei const stride = sizeof(ShapeInstance);
+  auto at = [offset](size_t member) { return reinterpret_cast<void const*>(offset + member); };
+  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, at(offsetof(ShapeInstance, x)));
+  glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, at(offsetof(ShapeInstance, radius)));
+  glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, at(offsetof(ShapeInstance, color)));
+  glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, stride, at(offsetof(ShapeInstance, type)));
+
+  static constexpr ShaderName modelviewprojection_name("modelviewprojection");
+  static constexpr ShaderName pixel_size_name("pixel_size");
+
+  glUniformMatrix4fv(m_program->get_uniform_location(modelviewprojection_name),
+                     1, GL_FALSE, glm::value_ptr(m_modelviewprojection));
+
+  // length of the local x and y axis in pixels after projection
+  float const vx = 0.5f * static_cast<float>(gc.size().width());
+  float const vy = 0.5f * static_cast<float>(gc.size().height());
+  float const sx = glm::length(glm::vec2(m_modelviewprojection[0].x * vx, m_modelviewprojection[0].y * vy));
+  float const sy = glm::length(glm::vec2(m_modelviewprojection[1].x * vx, m_modelviewprojection[1].y * vy));
+  glUniform2f(m_program->get_uniform_location(pixel_size_name),
+              1.0f / std::max(sx, 1.0e-6f), 1.0f / std::max(sy, 1.0e-6f));
+
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(m_instances.size()));
+
+  m_instances.clear();
+
+  assert_gl();
+}
+
+} // namespace wstdisplay
+
+/* EOF */
@@ -0,0 +1,227 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "sprite_renderer.hpp"
+
+#include <algorithm>
+#include <assert.h>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "assert_gl.hpp"
+#include "graphics_context.hpp"
+#include "surface_drawing_parameters.hpp"
+
+namespace wstdisplay {
+
+namespace {
+
+const char sprite_vert_source[] = R"(#version 330 core
+
+layout(location = 0) in vec4 rect;
+layout(location = 1) in float angle;
+layout(location = 2) in vec4 uv;
+layout(location = 3) in vec4 diffuse;
+
+out vec2 texcoord_v;
+out vec4 diffuse_v;
+
+uniform mat4 modelviewprojection;
+
+void main()
+{
+  // triangle strip over the unit quad
+  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+  vec2 half_size = rect.zw * 0.5;
+  vec2 p = corner * rect.zw - half_size;
+
+  float a = radians(angle);
+  float s = sin(a);
+  float c = cos(a);
+  p = vec2(p.x * c - p.y * s, p.x * s + p.y * c) + rect.xy + half_size;
+
+  texcoord_v = mix(uv.xy, uv.zw, corner);
+  diffuse_v = diffuse;
+  gl_Position = modelviewprojection * vec4(p, 0.0, 1.0);
+}
+)";
+
+const char sprite_frag_source[] = R"(#version 330 core
+
+uniform sampler2D diffuse_texture;
+
+in vec2 texcoord_v;
+in vec4 diffuse_v;
+
+layout(location = 0) out vec4 fragRGBAf;
+
+void main()
+{
+  fragRGBAf = texture(diffuse_texture, texcoord_v) * diffuse_v;
+}
+)";
+
+uint16_t to_unorm16(float v)
+{
+  return static_cast<uint16_t>(std::clamp(v, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+uint8_t to_unorm8(float v)
+{
+  return static_cast<uint8_t>(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+} // namespace
+
+SpriteRenderer::SpriteRenderer(GLStateTracker& state, size_t capacity) :
+  m_program(),
+  m_vao(),
+  m_buffer(),
+  m_capacity(capacity - capacity % sizeof(SpriteInstance)),
+  m_offset(0)
+{
+  assert_gl();
+
+  m_program = ShaderProgram::from_string(sprite_vert_source, sprite_frag_source);
+
+  glGenVertexArrays(1, &m_vao);
+  glGenBuffers(1, &m_buffer);
+
+  state.bind_vertex_array(m_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_capacity), nullptr, GL_STREAM_DRAW);
+
+  for (GLuint loc = 0; loc < 4; ++loc) {
+    glEnableVertexAttribArray(loc);
+    glVertexAttribDivisor(loc, 1);
+  }
+
+  assert_gl();
+}
+
+SpriteRenderer::~SpriteRenderer()
+{
+  glDeleteBuffers(1, &m_buffer);
+  glDeleteVertexArrays(1, &m_vao);
+}
+
+size_t
+SpriteRenderer::upload(SurfacePtr const& surface, std::span<SurfaceDrawingParameters const> params)
+{
+  size_t const bytes = params.size() * sizeof(SpriteInstance);
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+
+  if (bytes > m_capacity) {
+    m_capacity = std::max(bytes, m_capacity * 2);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_capacity), nullptr, GL_STREAM_DRAW);
+    m_offset = 0;
+  } else if (m_offset + bytes > m_capacity) {
+    // orphan the storage instead of waiting for the GPU
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_capacity), nullptr, GL_STREAM_DRAW);
+    m_offset = 0;
+  }
+
+  auto* const instances = static_cast<SpriteInstance*>(
+    glMapBufferRange(GL_ARRAY_BUFFER, static_cast<GLintptr>(m_offset), static_cast<GLsizeiptr>(bytes),
+                     GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+  assert_gl();
+
+  geom::frect const& uv = surface->get_uv();
+  uint16_t const uv_left = to_unorm16(uv.left());
+  uint16_t const uv_top = to_unorm16(uv.top());
+  uint16_t const uv_right = to_unorm16(uv.right());
+  uint16_t const uv_bottom = to_unorm16(uv.bottom());
+
+  for (size_t i = 0; i < params.size(); ++i)
+  {
+    SurfaceDrawingParameters const& p = params[i];
+    SpriteInstance& instance = instances[i];
+
+    instance.x = p.pos.x();
+    instance.y = p.pos.y();
+    instance.width = surface->get_width() * p.scale.x;
+    instance.height = surface->get_height() * p.scale.y;
+    instance.angle = p.angle;
+
+    instance.u1 = p.hflip ? uv_right : uv_left;
+    instance.u2 = p.hflip ? uv_left : uv_right;
+    instance.v1 = p.vflip ? uv_bottom : uv_top;
+    instance.v2 = p.vflip ? uv_top : uv_bottom;
+
+    instance.r = to_unorm8(p.color.r);
+    instance.g = to_unorm8(p.color.g);
+    instance.b = to_unorm8(p.color.b);
+    instance.a = to_unorm8(p.color.a);
+  }
+
+  glUnmapBuffer(GL_ARRAY_BUFFER);
+  assert_gl();
+
+  size_t const offset = m_offset;
+  m_offset += bytes;
+  return offset;
+}
+
+void
+SpriteRenderer::draw(GraphicsContext& gc, SurfacePtr const& surface,
+                     std::span<SurfaceDrawingParameters const> params)
+{
+  if (params.empty()) {
+    return;
+  }
+
+  GL_DEBUG_SCOPE("SpriteRenderer::draw");
+
+  gc.flush();
+
+  GLStateTracker& state = gc.get_state();
+  state.use_program(m_program);
+  state.set_enabled(GL_DEPTH_TEST, params.front().depth_test);
+  state.enable(GL_BLEND);
+  state.blend_func(params.front().blendfunc_src, params.front().blendfunc_dst);
+  state.bind_texture(0, surface->get_texture());
+  state.bind_vertex_array(m_vao);
+
+  size_t const offset = upload(surface, params);
+
+  // GL 3.3 has no base instance, so point the attributes at the
+  // freshly written range instead
+  GLsizei const stride = sizeof(SpriteInstance);
+  auto at = [offset](size_t member) { return reinterpret_cast<void const*>(offset + member); };
+  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, at(offsetof(SpriteInstance, x)));
+  glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, stride, at(offsetof(SpriteInstance, angle)));
+  glVertexAttribPointer(2, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, at(offsetof(SpriteInstance, u1)));
+  glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, at(offsetof(SpriteInstance, r)));
+
+  static constexpr ShaderName modelviewprojection_name("modelviewprojection");
+  static constexpr ShaderName diffuse_texture_name("diffuse_texture");
+
+  glm::mat4 const modelviewprojection = gc.get_projection() * gc.get_modelview();
+  glUniformMatrix4fv(m_program->get_uniform_location(modelviewprojection_name),
+                     1, GL_FALSE, glm::value_ptr(modelviewprojection));
+  glUniform1i(m_program->get_uniform_location(diffuse_texture_name), 0);
+
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(params.size()));
+
+  assert_gl();
+}
+
+} // namespace wstdisplay
+
+/* EOF */
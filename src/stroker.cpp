@@ -0,0 +1,308 @@
+// Windstille Display Library
+// Copyright (C) 2020 Ingo Ruhnke <grumbel@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "stroker.hpp"
+
+#include <math.h>
+#include <algorithm>
+
+#include <glm/gtc/constants.hpp>
+
+#include "circle_table.hpp"
+#include "scenegraph/vertex_array_drawable.hpp"
+
+namespace wstdisplay {
+
+namespace {
+
+glm::vec2 perpendicular(glm::vec2 const& v)
+{
+  return glm::vec2(-v.y, v.x);
+}
+
+float cross(glm::vec2 const& a, glm::vec2 const& b)
+{
+  return a.x * b.y - a.y * b.x;
+}
+
+/** The point where the inner edges of two segments meet at \a p, or
+    nothing when it lies further than \a max_inset along the segments */
+std::optional<glm::vec2> inner_corner(glm::vec2 const& p, glm::vec2 const& d0, glm::vec2 const& d1,
+                                      float half_width, float max_inset)
+{
+  float const turn = cross(d0, d1);
+  if (fabsf(turn) < 1.0e-6f) {
+    return std::nullopt;
+  }
+
+  float const side = (turn > 0.0f) ? 1.0f : -1.0f;
+  glm::vec2 const a = perpendicular(d0) * side * half_width;
+  glm::vec2 const b = perpendicular(d1) * side * half_width;
+
+  float const denom = glm::dot(a + b, a);
+  if (denom <= 1.0e-6f) {
+    return std::nullopt;
+  }
+
+  glm::vec2 const corner = (a + b) * (half_width * half_width / denom);
+  if (fabsf(glm::dot(corner, d0)) > max_inset) {
+    return std::nullopt;
+  }
+
+  return p + corner;
+}
+
+} // namespace
+
+Stroker::Stroker() :
+  m_points(),
+  m_inner(),
+  m_vertices(),
+  m_indices(),
+  m_rebased()
+{
+}
+
+void
+Stroker::clear()
+{
+  m_vertices.clear();
+  m_indices.clear();
+}
+
+uint32_t
+Stroker::add_vertex(glm::vec2 const& v)
+{
+  m_vertices.push_back(v);
+  return static_cast<uint32_t>(m_vertices.size() - 1);
+}
+
+void
+Stroker::stroke(std::span<glm::vec2 const> points, bool closed, StrokeStyle const& style)
+{
+  float const half_width = style.width * 0.5f;
+
+  // zero length segments have no direction
+  m_points.clear();
+  for (glm::vec2 const& p : points) {
+    if (m_points.empty() || glm::length(p - m_points.back()) > 1.0e-6f) {
+      m_points.push_back(p);
+    }
+  }
+
+  if (closed && m_points.size() > 1 && glm::length(m_points.front() - m_points.back()) <= 1.0e-6f) {
+    m_points.pop_back();
+  }
+
+  size_t const n = m_points.size();
+  if (n < 2) {
+    return;
+  }
+
+  // a closed line needs at least a triangle
+  closed = closed && n > 2;
+
+  size_t const segments = closed ? n : n - 1;
+
+  auto point = [&](size_t i) { return m_points[i % n]; };
+  auto direction = [&](size_t i) { return glm::normalize(point(i + 1) - point(i)); };
+  auto length = [&](size_t i) { return glm::length(point(i + 1) - point(i)); };
+
+  // the quads on both sides of a join share its inner corner, so
+  // that they don't overlap on the inside of the turn
+  m_inner.assign(n, std::nullopt);
+  for (size_t i = closed ? 0 : 1; i < (closed ? n : n - 1); ++i) {
+    size_t const prev = i + n - 1;
+    m_inner[i] = inner_corner(point(i), direction(prev), direction(i), half_width,
+                              0.5f * std::min(length(prev), length(i)));
+  }
+
+  for (size_t i = 0; i < segments; ++i)
+  {
+    glm::vec2 a = point(i);
+    glm::vec2 b = point(i + 1);
+
+    if (!closed && style.cap == LineCap::SQUARE) {
+      glm::vec2 const d = direction(i) * half_width;
+      if (i == 0) {
+        a = a - d;
+      }
+      if (i == segments - 1) {
+        b = b + d;
+      }
+    }
+
+    add_quad(a, b, half_width, m_inner[i], m_inner[(i + 1) % n]);
+  }
+
+  if (closed) {
+    for (size_t i = 0; i < n; ++i) {
+      add_join(point(i), direction(i + n - 1), direction(i), style, m_inner[i]);
+    }
+  } else {
+    for (size_t i = 1; i + 1 < n; ++i) {
+      add_join(point(i), direction(i - 1), direction(i), style, m_inner[i]);
+    }
+
+    add_cap(point(0), -direction(0), style);
+    add_cap(point(n - 1), direction(n - 2), style);
+  }
+}
+
+void
+Stroker::add_quad(glm::vec2 const& a, glm::vec2 const& b, float half_width,
+                  std::optional<glm::vec2> const& a_inner, std::optional<glm::vec2> const& b_inner)
+{
+  glm::vec2 const n = perpendicular(glm::normalize(b - a)) * half_width;
+
+  glm::vec2 corners[4] = { a + n, a - n, b + n, b - n };
+  if (a_inner) {
+    corners[glm::dot(*a_inner - a, n) > 0.0f ? 0 : 1] = *a_inner;
+  }
+  if (b_inner) {
+    corners[glm::dot(*b_inner - b, n) > 0.0f ? 2 : 3] = *b_inner;
+  }
+
+  uint32_t const first = add_vertex(corners[0]);
+  add_vertex(corners[1]);
+  add_vertex(corners[2]);
+  add_vertex(corners[3]);
+
+  m_indices.insert(m_indices.end(), {first + 0, first + 1, first + 2,
+                                     first + 2, first + 1, first + 3});
+}
+
+void
+Stroker::add_join(glm::vec2 const& p, glm::vec2 const& d0, glm::vec2 const& d1, StrokeStyle const& style,
+                  std::optional<glm::vec2> const& inner)
+{
+  float const half_width = style.width * 0.5f;
+  float const turn = cross(d0, d1);
+  float const straight = glm::dot(d0, d1);
+
+  if (fabsf(turn) < 1.0e-6f && straight > 0.0f) {
+    return;
+  }
+
+  // the gap to fill is on the outside of the turn
+  float const side = (turn > 0.0f) ? -1.0f : 1.0f;
+  glm::vec2 const a = perpendicular(d0) * side * half_width;
+  glm::vec2 const b = perpendicular(d1) * side * half_width;
+
+  LineJoin join = style.join;
+
+  glm::vec2 miter(0.0f, 0.0f);
+  if (join == LineJoin::MITER) {
+    float const denom = glm::dot(a + b, a);
+    if (denom <= 1.0e-6f) {
+      join = LineJoin::BEVEL;
+    } else {
+      miter = (a + b) * (half_width * half_width / denom);
+      // same ratio as SVG's stroke-miterlimit
+      if (glm::length(miter) > style.miter_limit * half_width) {
+        join = LineJoin::BEVEL;
+      }
+    }
+  }
+
+  switch (join)
+  {
+    case LineJoin::ROUND:
+      add_round(p, a, atan2f(turn, straight), half_width);
+      break;
+
+    case LineJoin::MITER: {
+      uint32_t const c = add_vertex(p);
+      uint32_t const va = add_vertex(p + a);
+      uint32_t const vm = add_vertex(p + miter);
+      uint32_t const vb = add_vertex(p + b);
+      m_indices.insert(m_indices.end(), {c, va, vm, c, vm, vb});
+      break;
+    }
+
+    case LineJoin::BEVEL: {
+      uint32_t const c = add_vertex(p);
+      uint32_t const va = add_vertex(p + a);
+      uint32_t const vb = add_vertex(p + b);
+      m_indices.insert(m_indices.end(), {c, va, vb});
+      break;
+    }
+  }
+
+  // the quads got clipped to the inner corner, fill up to the join
+  if (inner) {
+    uint32_t const c = add_vertex(p);
+    uint32_t const vi = add_vertex(*inner);
+    uint32_t const va = add_vertex(p + a);
+    uint32_t const vb = add_vertex(p + b);
+    m_indices.insert(m_indices.end(), {vi, va, c, vi, c, vb});
+  }
+}
+
+void
+Stroker::add_cap(glm::vec2 const& p, glm::vec2 const& d, StrokeStyle const& style)
+{
+  // SQUARE caps are done by extending the end segments
+  if (style.cap == LineCap::ROUND) {
+    float const half_width = style.width * 0.5f;
+    // half a turn from the left side through the tip to the right
+    add_round(p, perpendicular(d) * half_width, -glm::pi<float>(), half_width);
+  }
+}
+
+void
+Stroker::add_round(glm::vec2 const& center, glm::vec2 const& from, float angle, float half_width)
+{
+  int const steps = std::max(1, static_cast<int>(ceilf(fabsf(angle) / glm::two_pi<float>() *
+                                                       static_cast<float>(circle_segments(half_width)))));
+
+  uint32_t const c = add_vertex(center);
+  uint32_t prev = add_vertex(center + from);
+
+  for (int i = 1; i <= steps; ++i)
+  {
+    float const t = angle * static_cast<float>(i) / static_cast<float>(steps);
+    float const s = sinf(t);
+    float const co = cosf(t);
+
+    uint32_t const v = add_vertex(center + glm::vec2(from.x * co - from.y * s,
+                                                     from.x * s + from.y * co));
+    m_indices.insert(m_indices.end(), {c, prev, v});
+    prev = v;
+  }
+}
+
+void
+Stroker::append(VertexArrayDrawable& va, RGBA8 color) const
+{
+  uint32_t const base = static_cast<uint32_t>(va.num_vertices());
+
+  va.reserve(static_cast<int>(m_vertices.size()));
+  for (glm::vec2 const& v : m_vertices) {
+    va.color(color);
+    va.vertex(v.x, v.y);
+  }
+
+  m_rebased.resize(m_indices.size());
+  std::transform(m_indices.begin(), m_indices.end(), m_rebased.begin(),
+                 [base](uint32_t idx) { return base + idx; });
+  va.add_indices(std::span<uint32_t const>(m_rebased));
+}
+
+} // namespace wstdisplay
+
+/* EOF */
@@ -102,6 +102,13 @@ Surface::get_uv() const
   return m_uv;
 }
 
+void
+Surface::relocate(TexturePtr texture, const geom::frect& uv)
+{
+  m_texture = std::move(texture);
+  m_uv = uv;
+}
+
 void
 Surface::draw(GraphicsContext& gc, geom::fpoint const& pos) const
 {
@@ -110,7 +117,8 @@ Surface::draw(GraphicsContext& gc, geom::fpoint const& pos) const
   va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   va.set_texture(m_texture);
 
-  va.set_mode(GL_TRIANGLE_FAN);
+  va.set_mode(GL_TRIANGLES);
+  va.begin(GL_TRIANGLE_FAN);
 
   va.texcoord(m_uv.left(), m_uv.top());
   va.vertex(pos.x(), pos.y());
@@ -124,6 +132,8 @@ Surface::draw(GraphicsContext& gc, geom::fpoint const& pos) const
   va.texcoord(m_uv.left(), m_uv.bottom());
   va.vertex(pos.x(), pos.y() + m_size.height());
 
+  va.end();
+
   va.render(gc);
 }
 
@@ -135,7 +145,8 @@ Surface::draw(GraphicsContext& gc, geom::frect const& dstrect) const
   va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   va.set_texture(m_texture);
 
-  va.set_mode(GL_TRIANGLE_FAN);
+  va.set_mode(GL_TRIANGLES);
+  va.begin(GL_TRIANGLE_FAN);
 
   va.texcoord(m_uv.left(), m_uv.top());
   va.vertex(dstrect.left(), dstrect.top());
@@ -149,6 +160,8 @@ Surface::draw(GraphicsContext& gc, geom::frect const& dstrect) const
   va.texcoord(m_uv.left(), m_uv.bottom());
   va.vertex(dstrect.left(), dstrect.bottom());
 
+  va.end();
+
   va.render(gc);
 }
 
@@ -166,7 +179,8 @@ Surface::draw(GraphicsContext& gc, geom::frect const& srcrect, geom::frect const
   va.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   va.set_texture(m_texture);
 
-  va.set_mode(GL_TRIANGLE_FAN);
+  va.set_mode(GL_TRIANGLES);
+  va.begin(GL_TRIANGLE_FAN);
 
   va.texcoord(uv.left(), uv.top());
   va.vertex(dstrect.left(), dstrect.top());
@@ -180,6 +194,8 @@ Surface::draw(GraphicsContext& gc, geom::frect const& srcrect, geom::frect const
   va.texcoord(uv.left(), uv.bottom());
   va.vertex(dstrect.left(), dstrect.bottom());
 
+  va.end();
+
   va.render(gc);
 }
 
@@ -189,9 +205,17 @@ Surface::draw(GraphicsContext& gc, const SurfaceDrawingParameters& params) const
   VertexArrayDrawable va;
   va.set_blend_func(params.blendfunc_src, params.blendfunc_dst);
   va.set_texture(m_texture);
+  va.set_depth_test(params.depth_test);
 
-  va.set_mode(GL_TRIANGLE_FAN);
+  va.set_mode(GL_TRIANGLES);
+  append(va, params);
+
+  va.render(gc);
+}
 
+void
+Surface::append(VertexArrayDrawable& va, const SurfaceDrawingParameters& params) const
+{
   float uv_left = m_uv.left();
   float uv_top = m_uv.top();
   float uv_right = m_uv.right();
@@ -212,25 +236,18 @@ Surface::draw(GraphicsContext& gc, const SurfaceDrawingParameters& params) const
 
   quad.rotate(params.angle);
 
-  va.set_depth_test(params.depth_test);
-
-  va.color(params.color);
-  va.texcoord(uv_left, uv_top);
-  va.vertex(quad.p1.x(), quad.p1.y(), params.z_pos);
-
-  va.color(params.color);
-  va.texcoord(uv_right, uv_top);
-  va.vertex(quad.p2.x(), quad.p2.y(), params.z_pos);
-
-  va.color(params.color);
-  va.texcoord(uv_right, uv_bottom);
-  va.vertex(quad.p3.x(), quad.p3.y(), params.z_pos);
-
-  va.color(params.color);
-  va.texcoord(uv_left, uv_bottom);
-  va.vertex(quad.p4.x(), quad.p4.y(), params.z_pos);
+  auto corner = [&](geom::fpoint const& p, float u, float v) {
+    va.color(params.color);
+    va.texcoord(u, v);
+    va.vertex(p.x(), p.y(), params.z_pos);
+  };
 
-  va.render(gc);
+  va.begin(GL_TRIANGLE_FAN);
+  corner(quad.p1, uv_left, uv_top);
+  corner(quad.p2, uv_right, uv_top);
+  corner(quad.p3, uv_right, uv_bottom);
+  corner(quad.p4, uv_left, uv_bottom);
+  va.end();
 }
 
 } // namespace wstdisplay
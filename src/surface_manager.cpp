@@ -21,6 +21,7 @@
 
 #include <glm/gtc/round.hpp>
 
+#include "atlas_file.hpp"
 #include "software_surface.hpp"
 #include "texture_packer.hpp"
 
@@ -28,6 +29,8 @@ namespace wstdisplay {
 
 SurfaceManager::SurfaceManager() :
   m_texture_packer(),
+  m_atlas(),
+  m_atlas_files(),
   m_surfaces()
 {
   // NPOV should be ok with OpenGL2.0 in theory, but in practice there
@@ -60,10 +63,29 @@ SurfaceManager::get(std::filesystem::path const& filename)
     return it->second;
   }
 
+  // look for it in the baked atlases
+  std::string const name = filename.lexically_normal().generic_string();
+  for (LoadedAtlas const& atlas : m_atlas_files) {
+    if (AtlasFileEntry const* entry = atlas.file->find(name)) {
+      SurfacePtr result = Surface::create(atlas.pages[entry->page],
+                                          geom::frect(entry->u1, entry->v1, entry->u2, entry->v2),
+                                          geom::fsize(entry->width, entry->height));
+      m_surfaces[filename] = result;
+      return result;
+    }
+  }
+
   // load Surface from file
   SoftwareSurface software_surface = SoftwareSurface::from_file(filename);
 
-  if (m_texture_packer) {
+  // without atlas options the packer only exists for hardware
+  // without NPOT support and takes everything
+  bool const pack = m_texture_packer &&
+    (!m_atlas ||
+     (software_surface.get_width()  <= m_atlas->max_surface_size &&
+      software_surface.get_height() <= m_atlas->max_surface_size));
+
+  if (pack) {
     SurfacePtr result = m_texture_packer->upload(software_surface);
     m_surfaces[filename] = result;
     return result;
@@ -149,12 +171,60 @@ SurfaceManager::create_texture(SoftwareSurface const& image,
   }
 }
 
+void
+SurfaceManager::set_atlas(AtlasOptions const& options)
+{
+  // surfaces already handed out keep their textures alive
+  m_atlas = options;
+  m_texture_packer.reset(new TexturePacker(options.page_size, options.padding));
+}
+
+void
+SurfaceManager::load_atlas(std::filesystem::path const& filename)
+{
+  LoadedAtlas atlas;
+  atlas.file = std::make_unique<AtlasFile>(filename);
+
+  GLint max_texture_size = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+  if (atlas.file->get_page_size().width() > max_texture_size ||
+      atlas.file->get_page_size().height() > max_texture_size) {
+    std::ostringstream msg;
+    msg << "Couldn't load atlas '" << filename.string() << "': pages exceed GL_MAX_TEXTURE_SIZE of " << max_texture_size;
+    throw std::runtime_error(msg.str());
+  }
+
+  // the pages are stored in texture layout, so they go up unchanged
+  for (int page = 0; page < atlas.file->get_page_count(); ++page) {
+    TexturePtr texture = Texture::create(GL_TEXTURE_2D, atlas.file->get_page_size());
+    texture->put(atlas.file->get_page_data(page), atlas.file->get_page_size(), 0, 0);
+    atlas.pages.push_back(std::move(texture));
+  }
+
+  m_atlas_files.push_back(std::move(atlas));
+}
+
 void
 SurfaceManager::cleanup()
 {
+  // the cache itself holds one reference
   std::erase_if(m_surfaces, [](auto const& item) {
-    return item.second.use_count() == 0;
+    return item.second.use_count() == 1;
   });
+
+  if (m_texture_packer) {
+    m_texture_packer->collect();
+  }
+}
+
+int
+SurfaceManager::defragment(int max_moves)
+{
+  if (!m_texture_packer) {
+    return 0;
+  }
+
+  return m_texture_packer->defragment(max_moves);
 }
 
 void
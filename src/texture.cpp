@@ -27,11 +27,33 @@
 #include <geom/io.hpp>
 
 #include "assert_gl.hpp"
+#include "gl_state_tracker.hpp"
 #include "software_surface.hpp"
 #include "texture_manager.hpp"
 
 namespace wstdisplay {
 
+namespace {
+
+/** Bind a texture for modification on the scratch unit, which
+    GLStateTracker never binds to, so no binding has to be queried or
+    restored afterwards */
+class TextureBinding
+{
+public:
+  TextureBinding(GLuint handle)
+  {
+    glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(GLStateTracker::SCRATCH_TEXTURE_UNIT));
+    glBindTexture(GL_TEXTURE_2D, handle);
+  }
+
+private:
+  TextureBinding(const TextureBinding&) = delete;
+  TextureBinding& operator=(const TextureBinding&) = delete;
+};
+
+} // namespace
+
 TexturePtr
 Texture::create(SoftwareSurface const& image, GLint format)
 {
@@ -72,7 +94,7 @@ Texture::Texture(GLenum target, geom::isize const& size, GLint format) :
   glGenTextures(1, &m_handle);
   assert_gl();
 
-  glBindTexture(GL_TEXTURE_2D, m_handle);
+  TextureBinding binding(m_handle);
 
   glTexImage2D(target, 0, format, m_size.width(), m_size.height(), 0, GL_RGBA,
                GL_UNSIGNED_BYTE, nullptr);
@@ -91,6 +113,7 @@ Texture::Texture(SoftwareSurface const& image, GLint glformat) :
   m_handle(0),
   m_size(image.get_size())
 {
+  GL_DEBUG_SCOPE("Texture::Texture");
   assert_gl();
 
   glGenTextures(1, &m_handle);
@@ -141,7 +164,7 @@ Texture::Texture(SoftwareSurface const& image, GLint glformat) :
       throw std::runtime_error("Texture: Image format not supported");
     }
 
-    glBindTexture(GL_TEXTURE_2D, m_handle);
+    TextureBinding binding(m_handle);
 
     glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     glPixelStorei(GL_UNPACK_ROW_LENGTH, image.get_pitch() / bytes_per_pixel);
@@ -211,6 +234,7 @@ Texture::get_handle() const
 void
 Texture::put(SoftwareSurface const& image, const geom::irect& srcrect, int x, int y)
 {
+  GL_DEBUG_SCOPE("Texture::put");
   assert_gl();
 
   GLint sdl_format;
@@ -231,7 +255,7 @@ Texture::put(SoftwareSurface const& image, const geom::irect& srcrect, int x, in
     throw std::runtime_error("Texture: SoftwareSurface format not supported");
   }
 
-  glBindTexture(GL_TEXTURE_2D, m_handle);
+  TextureBinding binding(m_handle);
 
   // FIXME: Add some checks here to make sure image has the right format
   glPixelStorei(GL_UNPACK_ALIGNMENT, 4); // FIXME: Does SDL always use 4?
@@ -247,6 +271,61 @@ Texture::put(SoftwareSurface const& image, const geom::irect& srcrect, int x, in
   assert_gl();
 }
 
+void
+Texture::put(void const* pixels, geom::isize const& size, int x, int y)
+{
+  GL_DEBUG_SCOPE("Texture::put");
+  assert_gl();
+
+  TextureBinding binding(m_handle);
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+  glTexSubImage2D(m_target, 0, x, y, size.width(), size.height(),
+                  GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+  assert_gl();
+}
+
+void
+Texture::copy(Texture const& source, const geom::irect& srcrect, int x, int y)
+{
+  GL_DEBUG_SCOPE("Texture::copy");
+  assert_gl();
+
+  if (GLEW_ARB_copy_image)
+  {
+    glCopyImageSubData(source.m_handle, source.m_target, 0, srcrect.left(), srcrect.top(), 0,
+                       m_handle, m_target, 0, x, y, 0,
+                       srcrect.width(), srcrect.height(), 1);
+  }
+  else
+  {
+    // attach the source to a temporary read framebuffer, the draw
+    // framebuffer is left alone
+    GLint previous = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+
+    GLuint framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           source.m_target, source.m_handle, 0);
+
+    {
+      TextureBinding binding(m_handle);
+      glCopyTexSubImage2D(m_target, 0, x, y,
+                          srcrect.left(), srcrect.top(), srcrect.width(), srcrect.height());
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previous));
+    glDeleteFramebuffers(1, &framebuffer);
+  }
+
+  assert_gl();
+}
+
 void
 Texture::put(SoftwareSurface const& image, int x, int y)
 {
@@ -258,7 +337,7 @@ Texture::set_wrap(GLenum mode)
 {
   assert_gl();
 
-  glBindTexture(GL_TEXTURE_2D, m_handle);
+  TextureBinding binding(m_handle);
 
   glTexParameteri(m_target, GL_TEXTURE_WRAP_S, mode);
   glTexParameteri(m_target, GL_TEXTURE_WRAP_T, mode);
@@ -272,7 +351,7 @@ Texture::set_filter(GLenum mode)
 {
   assert_gl();
 
-  glBindTexture(GL_TEXTURE_2D, m_handle);
+  TextureBinding binding(m_handle);
 
   glTexParameteri(m_target, GL_TEXTURE_MIN_FILTER, mode);
   glTexParameteri(m_target, GL_TEXTURE_MAG_FILTER, mode);
@@ -283,7 +362,7 @@ Texture::set_filter(GLenum mode)
 SoftwareSurface
 Texture::get_software_surface() const
 {
-  glBindTexture(GL_TEXTURE_2D, m_handle);
+  TextureBinding binding(m_handle);
 
   SoftwareSurface surface = SoftwareSurface::create(surf::PixelFormat::RGBA8, m_size);
 
@@ -14,7 +14,10 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include <iostream>
+#include <numeric>
+#include <optional>
 #include <stdexcept>
 #include <stdio.h>
 #include <memory>
@@ -23,81 +26,34 @@
 #include <geom/rect.hpp>
 #include <surf/save.hpp>
 
+#include "blitter.hpp"
+#include "rect_packer.hpp"
 #include "software_surface.hpp"
 #include "texture_packer.hpp"
 
 namespace wstdisplay {
 
-class TextureSpace
+class TexturePackerTexture
 {
-private:
-  geom::irect          rect;
-  bool          used;
-  std::unique_ptr<TextureSpace> left;
-  std::unique_ptr<TextureSpace> right;
-
 public:
-  TextureSpace(const geom::irect& rect_) :
-    rect(rect_),
-    used(false),
-    left(),
-    right()
-  {}
-
-  ~TextureSpace()
-  {}
-
-  bool allocate(const geom::isize& size, geom::irect& out_rect)
+  struct Allocation
   {
-    if (size.width()  <= rect.width() &&
-        size.height() <= rect.height())
-    {
-      if (!used)
-      {
-        used = true;
-        out_rect = geom::irect(geom::ipoint(rect.left(), rect.top()), size);
-
-        // FIXME: Make this alterate between horizontal and
-        // vertical splitting or chose whichever split options
-        // leads to less 'ugly' rectangle (how much different does
-        // this make in terms of packing density?)
-        left.reset(new TextureSpace(geom::irect(out_rect.left(),  out_rect.bottom(),
-                                         out_rect.right(), rect.bottom())));
-
-        right.reset(new TextureSpace(geom::irect(out_rect.right(), out_rect.top(),
-                                          rect.right(), rect.bottom())));
-
-        return true;
-      }
-      else
-      {
-        return
-          left->allocate(size, out_rect) ||
-          right->allocate(size, out_rect);
-      }
-    }
-    else
-    {
-      // geom::isize doesn't fit here
-      return false;
-    }
-  }
+    std::weak_ptr<Surface> surface;
 
-private:
-  TextureSpace(const TextureSpace&);
-  TextureSpace& operator=(const TextureSpace&);
-};
+    /** allocated rect, including the padding */
+    geom::irect rect;
+  };
 
-class TexturePackerTexture
-{
 private:
   TexturePtr     texture;
-  TextureSpace   space;
+  RectPacker     space;
+  std::vector<Allocation> allocations;
 
 public:
   TexturePackerTexture(const geom::isize& size) :
     texture(Texture::create(GL_TEXTURE_2D, size)),
-    space(geom::irect(geom::ipoint(0, 0), size))
+    space(size),
+    allocations()
   {
   }
 
@@ -105,11 +61,14 @@ public:
   {}
 
   TexturePtr get_texture() const { return texture; }
+  RectPacker const& get_space() const { return space; }
+  std::vector<Allocation>& get_allocations() { return allocations; }
 
   bool allocate(const geom::isize& size, geom::irect& out_rect, TexturePtr& out_texture)
   {
-    if (space.allocate(size, out_rect))
+    if (std::optional<geom::irect> rect = space.insert(size))
     {
+      out_rect = *rect;
       out_texture = texture;
       return true;
     }
@@ -119,13 +78,46 @@ public:
     }
   }
 
+  /** Keep track of \a surface, so that \a rect can be freed once it
+      is gone */
+  void track(SurfacePtr const& surface, const geom::irect& rect)
+  {
+    allocations.push_back(Allocation{surface, rect});
+  }
+
+  /** Stop tracking allocation \a idx and return its space */
+  void release(size_t idx)
+  {
+    space.free(allocations[idx].rect);
+    allocations[idx] = allocations.back();
+    allocations.pop_back();
+  }
+
+  /** No tracked surface is left, space handed out by a plain
+      allocate() keeps the page alive */
+  bool empty() const { return space.get_count() == 0; }
+
 private:
   TexturePackerTexture(const TexturePackerTexture&);
   TexturePackerTexture& operator=(const TexturePackerTexture&);
 };
 
-TexturePacker::TexturePacker(const geom::isize& texture_size_) :
+namespace {
+
+/** uv coordinates of the surface inside the padded \a rect */
+geom::frect inner_uv(const geom::irect& rect, int padding, Texture const& texture)
+{
+  return geom::frect(static_cast<float>(rect.left() + padding)   / static_cast<float>(texture.get_width()),
+                     static_cast<float>(rect.top() + padding)    / static_cast<float>(texture.get_height()),
+                     static_cast<float>(rect.right() - padding)  / static_cast<float>(texture.get_width()),
+                     static_cast<float>(rect.bottom() - padding) / static_cast<float>(texture.get_height()));
+}
+
+} // namespace
+
+TexturePacker::TexturePacker(const geom::isize& texture_size_, int padding_) :
   texture_size(texture_size_),
+  padding(std::max(padding_, 0)),
   textures()
 {
 }
@@ -155,10 +147,13 @@ TexturePacker::allocate(const geom::isize& size, geom::irect& rect, TexturePtr&
 SurfacePtr
 TexturePacker::upload(SoftwareSurface const& surface)
 {
-  // Add a 1px border around surfaces to avoid blending artifacts
+  // Add a border around surfaces to avoid blending artifacts
   //SoftwareSurface surface = in_surface.add_1px_border();
 
-  geom::isize    size(surface.get_width()+2, surface.get_height()+2);
+  int const w = surface.get_width();
+  int const h = surface.get_height();
+
+  geom::isize    size(w + 2 * padding, h + 2 * padding);
   geom::irect    rect;
   TexturePtr texture;
 
@@ -168,41 +163,146 @@ TexturePacker::upload(SoftwareSurface const& surface)
   }
   else
   {
-    // duplicate border pixel
-
-    // top
-    texture->put(surface, geom::irect(geom::ipoint(0, 0), geom::isize(surface.get_width(), 1)),
-                 rect.left()+1, rect.top());
-    // bottom
-    texture->put(surface, geom::irect(geom::ipoint(0, surface.get_height()-1), geom::isize(surface.get_width(), 1)),
-                 rect.left()+1, rect.bottom()-1);
-    // left
-    texture->put(surface, geom::irect(geom::ipoint(0, 0), geom::isize(1, surface.get_height())),
-                 rect.left(), rect.top()+1);
-    // right
-    texture->put(surface, geom::irect(geom::ipoint(surface.get_width()-1, 0), geom::isize(1, surface.get_height())),
-                 rect.right()-1, rect.top()+1);
-
-    // duplicate corner pixels
-    texture->put(surface, geom::irect(geom::ipoint(0, 0), geom::isize(1, 1)),
-                 rect.left(), rect.top());
-    texture->put(surface, geom::irect(geom::ipoint(surface.get_width()-1, 0), geom::isize(1, 1)),
-                 rect.right()-1, rect.top());
-    texture->put(surface, geom::irect(geom::ipoint(surface.get_width()-1, surface.get_height()-1), geom::isize(1, 1)),
-                 rect.right()-1, rect.bottom()-1);
-    texture->put(surface, geom::irect(geom::ipoint(0, surface.get_height()-1), geom::isize(1, 1)),
-                 rect.left(), rect.bottom()-1);
-
-    // draw the main surface
-    texture->put(surface, rect.left()+1, rect.top()+1);
-
-    return Surface::create(texture,
-                           geom::frect(static_cast<float>(rect.left()+1)   / static_cast<float>(texture->get_width()),
-                                 static_cast<float>(rect.top()+1)    / static_cast<float>(texture->get_height()),
-                                 static_cast<float>(rect.right()-1)  / static_cast<float>(texture->get_width()),
-                                 static_cast<float>(rect.bottom()-1) / static_cast<float>(texture->get_height())),
-                           geom::fsize(static_cast<float>(surface.get_width()), static_cast<float>(surface.get_height())));
+    // build the bordered image on the CPU, so that it takes a
+    // single upload
+    SoftwareSurface staging = SoftwareSurface::create(surf::PixelFormat::RGBA8, size);
+    blit_with_border(surface, staging, padding, padding, padding);
+    texture->put(staging, rect.left(), rect.top());
+
+    SurfacePtr result = Surface::create(texture, inner_uv(rect, padding, *texture),
+                                        geom::fsize(static_cast<float>(w), static_cast<float>(h)));
+
+    for(Textures::iterator i = textures.begin(); i != textures.end(); ++i)
+    {
+      if ((*i)->get_texture() == texture) {
+        (*i)->track(result, rect);
+        break;
+      }
+    }
+
+    return result;
+  }
+}
+
+std::vector<SurfacePtr>
+TexturePacker::upload(std::span<SoftwareSurface const> surfaces)
+{
+  // tall surfaces first, the rest then fills the gaps next to them
+  std::vector<size_t> order(surfaces.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&surfaces](size_t lhs, size_t rhs) {
+    return surfaces[lhs].get_height() > surfaces[rhs].get_height();
+  });
+
+  std::vector<SurfacePtr> result(surfaces.size());
+  for (size_t idx : order) {
+    result[idx] = upload(surfaces[idx]);
+  }
+  return result;
+}
+
+int
+TexturePacker::collect()
+{
+  int count = 0;
+
+  for(Textures::iterator i = textures.begin(); i != textures.end(); ++i)
+  {
+    std::vector<TexturePackerTexture::Allocation>& allocations = (*i)->get_allocations();
+    for(size_t idx = 0; idx < allocations.size();)
+    {
+      if (allocations[idx].surface.expired()) {
+        (*i)->release(idx);
+        count += 1;
+      } else {
+        ++idx;
+      }
+    }
+  }
+
+  std::erase_if(textures, [](TexturePackerTexture* page) {
+    if (page->empty()) {
+      delete page;
+      return true;
+    } else {
+      return false;
+    }
+  });
+
+  return count;
+}
+
+int
+TexturePacker::defragment(int max_moves)
+{
+  if (textures.size() < 2) {
+    return 0;
+  }
+
+  // empty the page that is used least, that is the one that can be
+  // released the soonest
+  Textures::iterator source = std::min_element(textures.begin(), textures.end(),
+                                               [](TexturePackerTexture* lhs, TexturePackerTexture* rhs) {
+                                                 return lhs->get_space().get_used_area() < rhs->get_space().get_used_area();
+                                               });
+
+  std::vector<TexturePackerTexture::Allocation>& allocations = (*source)->get_allocations();
+
+  int moves = 0;
+  while (moves < max_moves && !allocations.empty())
+  {
+    size_t const idx = allocations.size() - 1;
+    TexturePackerTexture::Allocation const& allocation = allocations[idx];
+
+    SurfacePtr surface = allocation.surface.lock();
+    if (!surface) {
+      (*source)->release(idx);
+      continue;
+    }
+
+    // only existing pages, a new one would defeat the purpose
+    geom::irect rect;
+    TexturePtr texture;
+    Textures::iterator target = textures.begin();
+    for(; target != textures.end(); ++target)
+    {
+      if (target != source && (*target)->allocate(allocation.rect.size(), rect, texture)) {
+        break;
+      }
+    }
+
+    if (target == textures.end()) {
+      break;
+    }
+
+    // the padding moves along with the surface
+    texture->copy(*(*source)->get_texture(), allocation.rect, rect.left(), rect.top());
+    surface->relocate(texture, inner_uv(rect, padding, *texture));
+
+    (*target)->track(surface, rect);
+    (*source)->release(idx);
+    moves += 1;
+  }
+
+  if ((*source)->empty()) {
+    delete *source;
+    textures.erase(source);
+  }
+
+  return moves;
+}
+
+std::vector<TexturePacker::PageInfo>
+TexturePacker::get_page_info() const
+{
+  std::vector<PageInfo> result;
+  result.reserve(textures.size());
+  for(Textures::const_iterator i = textures.begin(); i != textures.end(); ++i)
+  {
+    RectPacker const& space = (*i)->get_space();
+    result.push_back(PageInfo{(*i)->get_texture(), space.get_count(), space.get_occupancy()});
   }
+  return result;
 }
 
 void